@@ -0,0 +1,98 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Measures the time taken to compile and to execute display lists made of
+ * many state commands, to check that both scale linearly with the number of
+ * commands.
+ *
+ * Usage: bench_call_lists [COMMANDS...]
+ * where COMMANDS is the number of commands in the list (default: 1000, 10000
+ * and 50000).
+ */
+
+#include "bench.h"
+#include "opengx.h"
+
+#include <GL/gl.h>
+#include <stdlib.h>
+
+typedef struct {
+    GLuint list;
+    int num_commands;
+} Job;
+
+static void compile_list(void *user_data)
+{
+    const Job *job = user_data;
+    glNewList(job->list, GL_COMPILE);
+    /* Each iteration records four commands */
+    for (int i = 0; i < job->num_commands / 4; i++) {
+        glPushMatrix();
+        glTranslatef(i, 0.0f, -1.0f);
+        glColor4f(1.0f, 0.5f, 0.25f, 1.0f);
+        glPopMatrix();
+    }
+    glEndList();
+}
+
+static void call_list(void *user_data)
+{
+    const Job *job = user_data;
+    glCallList(job->list);
+}
+
+int main(int argc, char **argv)
+{
+    static const int default_counts[] = { 1000, 10000, 50000 };
+    int num_counts = argc > 1 ? argc - 1 : 3;
+    int counts[num_counts];
+    for (int i = 0; i < num_counts; i++) {
+        counts[i] = argc > 1 ? atoi(argv[i + 1]) : default_counts[i];
+        if (counts[i] < 4) {
+            fprintf(stderr, "Invalid command count %s\n", argv[i + 1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    ogx_initialize();
+
+    GLuint list = glGenLists(1);
+    printf("%10s %14s %14s %14s %14s\n", "Commands", "Compile (ms)",
+           "ns/command", "Execute (ms)", "ns/command");
+    for (int i = 0; i < num_counts; i++) {
+        Job job = { list, counts[i] / 4 * 4 };
+        double compile = bench_run(compile_list, &job);
+        double execute = bench_run(call_list, &job);
+        printf("%10d %14.3f %14.1f %14.3f %14.1f\n", job.num_commands,
+               compile * 1e3, compile * 1e9 / job.num_commands,
+               execute * 1e3, execute * 1e9 / job.num_commands);
+    }
+    glDeleteLists(list, 1);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+/* Measures the time taken to generate and delete many display lists, textures
+ * and buffers, as done when loading (and unloading) the assets of a program.
+ * The objects are generated one at a time, and then deleted together.
+ *
+ * Usage: bench_object_names
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include "bench.h"
+#include "opengx.h"
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <stdlib.h>
+
+typedef struct {
+    const char *name;
+    int count;
+    GLuint *names;
+} Job;
+
+static void gen_delete_lists(void *user_data)
+{
+    const Job *job = user_data;
+    for (int i = 0; i < job->count; i++) {
+        job->names[i] = glGenLists(1);
+    }
+    for (int i = 0; i < job->count; i++) {
+        glDeleteLists(job->names[i], 1);
+    }
+}
+
+static void gen_delete_textures(void *user_data)
+{
+    const Job *job = user_data;
+    for (int i = 0; i < job->count; i++) {
+        glGenTextures(1, &job->names[i]);
+    }
+    glDeleteTextures(job->count, job->names);
+}
+
+static void gen_delete_buffers(void *user_data)
+{
+    const Job *job = user_data;
+    for (int i = 0; i < job->count; i++) {
+        glGenBuffers(1, &job->names[i]);
+    }
+    glDeleteBuffers(job->count, job->names);
+}
+
+int main(int argc, char **argv)
+{
+    /* Close to the maximum number of objects of each kind */
+    Job jobs[] = {
+        { "Lists", 1500, NULL },
+        { "Textures", 2000, NULL },
+        { "Buffers", 250, NULL },
+    };
+    BenchFunc funcs[] = {
+        gen_delete_lists,
+        gen_delete_textures,
+        gen_delete_buffers,
+    };
+
+    ogx_initialize();
+
+    printf("%10s %10s %18s %14s\n", "Objects", "Count", "Gen+delete (ms)",
+           "ns/object");
+    for (int i = 0; i < sizeof(jobs) / sizeof(jobs[0]); i++) {
+        Job *job = &jobs[i];
+        job->names = malloc(job->count * sizeof(GLuint));
+        double elapsed = bench_run(funcs[i], job);
+        printf("%10s %10d %18.3f %14.1f\n", job->name, job->count,
+               elapsed * 1e3, elapsed * 1e9 / job->count);
+        free(job->names);
+    }
+    return EXIT_SUCCESS;
+}
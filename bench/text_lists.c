@@ -0,0 +1,136 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+/* Measures the time taken to render a string through display lists, one per
+ * glyph, as done by the text rendering code of many programs (and by
+ * glXUseXFont()).
+ *
+ * Usage: bench_text_lists [GLYPHS...]
+ * where GLYPHS is the length of the string (default: 2000).
+ */
+
+#include "bench.h"
+#include "opengx.h"
+
+#include <GL/gl.h>
+#include <stdlib.h>
+
+#define FIRST_GLYPH 32
+#define NUM_GLYPHS 95
+
+typedef struct {
+    GLubyte *text;
+    int length;
+} Job;
+
+static GLfloat s_positions[NUM_GLYPHS * 4][2];
+static GLfloat s_tex_coords[NUM_GLYPHS * 4][2];
+
+/* Each glyph is a textured quad, followed by a translation to the position
+ * of the next glyph */
+static void compile_glyphs()
+{
+    for (int i = 0; i < NUM_GLYPHS; i++) {
+        float width = 6.0f + i % 5;
+        float s = (i % 16) / 16.0f, t = (i / 16) / 8.0f;
+        GLfloat (*pos)[2] = &s_positions[i * 4];
+        GLfloat (*tex)[2] = &s_tex_coords[i * 4];
+        pos[0][0] = 0.0f;  pos[0][1] = 0.0f;  tex[0][0] = s; tex[0][1] = t;
+        pos[1][0] = width; pos[1][1] = 0.0f;  tex[1][0] = s + 1 / 16.0f;
+        tex[1][1] = t;
+        pos[2][0] = width; pos[2][1] = 12.0f; tex[2][0] = s + 1 / 16.0f;
+        tex[2][1] = t + 1 / 8.0f;
+        pos[3][0] = 0.0f;  pos[3][1] = 12.0f; tex[3][0] = s;
+        tex[3][1] = t + 1 / 8.0f;
+
+        glNewList(FIRST_GLYPH + i, GL_COMPILE);
+        glDrawArrays(GL_QUADS, i * 4, 4);
+        glTranslatef(width, 0.0f, 0.0f);
+        glEndList();
+    }
+}
+
+static void call_list_loop(void *user_data)
+{
+    const Job *job = user_data;
+    glPushMatrix();
+    for (int i = 0; i < job->length; i++) {
+        glCallList(job->text[i]);
+    }
+    glPopMatrix();
+}
+
+static void call_lists(void *user_data)
+{
+    const Job *job = user_data;
+    glPushMatrix();
+    glCallLists(job->length, GL_UNSIGNED_BYTE, job->text);
+    glPopMatrix();
+}
+
+int main(int argc, char **argv)
+{
+    int num_lengths = argc > 1 ? argc - 1 : 1;
+    int lengths[num_lengths];
+    for (int i = 0; i < num_lengths; i++) {
+        lengths[i] = argc > 1 ? atoi(argv[i + 1]) : 2000;
+        if (lengths[i] < 1) {
+            fprintf(stderr, "Invalid string length %s\n", argv[i + 1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    ogx_initialize();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, s_positions);
+    glTexCoordPointer(2, GL_FLOAT, 0, s_tex_coords);
+    compile_glyphs();
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    printf("%10s %18s %14s %18s %14s\n", "Glyphs", "glCallList (ms)",
+           "ns/glyph", "glCallLists (ms)", "ns/glyph");
+    for (int i = 0; i < num_lengths; i++) {
+        Job job = { malloc(lengths[i]), lengths[i] };
+        for (int c = 0; c < job.length; c++) {
+            job.text[c] = FIRST_GLYPH + (c * 7) % NUM_GLYPHS;
+        }
+        double loop = bench_run(call_list_loop, &job);
+        double batch = bench_run(call_lists, &job);
+        printf("%10d %18.3f %14.1f %18.3f %14.1f\n", job.length,
+               loop * 1e3, loop * 1e9 / job.length,
+               batch * 1e3, batch * 1e9 / job.length);
+        free(job.text);
+    }
+    glDeleteLists(FIRST_GLYPH, NUM_GLYPHS);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,222 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Measures the throughput of the texture conversion routines, comparing the
+ * fast converters (the ogx_fast_conv_* family) with the generic converter, for
+ * all the supported combinations of GL source formats and GX texture formats.
+ *
+ * Usage: bench_texture_conversion [SIZE...]
+ * where SIZE is the texture width and height (default: 64, 256 and 1024).
+ */
+
+#include "bench.h"
+#include "image_DXT.h"
+#include "opengx.h"
+#include "pixels.h"
+
+#include <GL/gl.h>
+#include <gccore.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef void (FastConverter)(const void *data, GLenum type,
+                             int width, int height,
+                             void *dst, int x, int y, int dstpitch);
+
+typedef struct {
+    const char *name;
+    GLenum format;
+    GLenum type;
+    int src_bytes_per_pixel;
+    uint8_t gx_format;
+    const uintptr_t *fast_conv; /* NULL if there's no fast converter */
+} ConversionCase;
+
+static const ConversionCase s_cases[] = {
+    { "RGBA/UNSIGNED_BYTE -> RGBA8", GL_RGBA, GL_UNSIGNED_BYTE, 4,
+        GX_TF_RGBA8, &ogx_fast_conv_RGBA_RGBA8 },
+    { "RGBA/UNSIGNED_BYTE -> RGB565", GL_RGBA, GL_UNSIGNED_BYTE, 4,
+        GX_TF_RGB565, &ogx_fast_conv_RGBA_RGB565 },
+    { "RGBA/UNSIGNED_BYTE -> IA8", GL_RGBA, GL_UNSIGNED_BYTE, 4,
+        GX_TF_IA8, &ogx_fast_conv_RGBA_IA8 },
+    { "RGBA/UNSIGNED_BYTE -> I8", GL_RGBA, GL_UNSIGNED_BYTE, 4,
+        GX_TF_I8, &ogx_fast_conv_RGBA_I8 },
+    { "RGBA/UNSIGNED_BYTE -> I4", GL_RGBA, GL_UNSIGNED_BYTE, 4,
+        GX_TF_I4, NULL },
+    { "RGBA/UNSIGNED_BYTE -> A8", GL_RGBA, GL_UNSIGNED_BYTE, 4,
+        GX_TF_A8, &ogx_fast_conv_RGBA_A8 },
+    { "RGBA/FLOAT -> RGBA8", GL_RGBA, GL_FLOAT, 16,
+        GX_TF_RGBA8, &ogx_fast_conv_RGBA_RGBA8 },
+    { "RGBA/UNSIGNED_SHORT_4_4_4_4 -> RGBA8", GL_RGBA,
+        GL_UNSIGNED_SHORT_4_4_4_4, 2, GX_TF_RGBA8, NULL },
+    { "RGB/UNSIGNED_BYTE -> RGBA8", GL_RGB, GL_UNSIGNED_BYTE, 3,
+        GX_TF_RGBA8, &ogx_fast_conv_RGB_RGBA8 },
+    { "RGB/UNSIGNED_BYTE -> RGB565", GL_RGB, GL_UNSIGNED_BYTE, 3,
+        GX_TF_RGB565, &ogx_fast_conv_RGB_RGB565 },
+    { "RGB/UNSIGNED_BYTE -> IA8", GL_RGB, GL_UNSIGNED_BYTE, 3,
+        GX_TF_IA8, &ogx_fast_conv_RGB_IA8 },
+    { "RGB/UNSIGNED_BYTE -> I8", GL_RGB, GL_UNSIGNED_BYTE, 3,
+        GX_TF_I8, &ogx_fast_conv_RGB_I8 },
+    { "RGB/UNSIGNED_BYTE -> I4", GL_RGB, GL_UNSIGNED_BYTE, 3,
+        GX_TF_I4, NULL },
+    { "RGB/FLOAT -> RGB565", GL_RGB, GL_FLOAT, 12,
+        GX_TF_RGB565, &ogx_fast_conv_RGB_RGB565 },
+    { "RGB/UNSIGNED_SHORT_5_6_5 -> RGB565", GL_RGB,
+        GL_UNSIGNED_SHORT_5_6_5, 2, GX_TF_RGB565, NULL },
+    { "RGB/UNSIGNED_BYTE -> CMPR", GL_RGB, GL_UNSIGNED_BYTE, 3,
+        GX_TF_CMPR, NULL },
+    { "LUMINANCE_ALPHA/UNSIGNED_BYTE -> IA8", GL_LUMINANCE_ALPHA,
+        GL_UNSIGNED_BYTE, 2, GX_TF_IA8, &ogx_fast_conv_LA_IA8 },
+    { "LUMINANCE_ALPHA/UNSIGNED_BYTE -> I8", GL_LUMINANCE_ALPHA,
+        GL_UNSIGNED_BYTE, 2, GX_TF_I8, &ogx_fast_conv_LA_I8 },
+    { "LUMINANCE_ALPHA/UNSIGNED_BYTE -> A8", GL_LUMINANCE_ALPHA,
+        GL_UNSIGNED_BYTE, 2, GX_TF_A8, &ogx_fast_conv_LA_A8 },
+    { "LUMINANCE/UNSIGNED_BYTE -> I8", GL_LUMINANCE, GL_UNSIGNED_BYTE, 1,
+        GX_TF_I8, &ogx_fast_conv_Intensity_I8 },
+    { "LUMINANCE/UNSIGNED_BYTE -> I4", GL_LUMINANCE, GL_UNSIGNED_BYTE, 1,
+        GX_TF_I4, NULL },
+    { "ALPHA/UNSIGNED_BYTE -> A8", GL_ALPHA, GL_UNSIGNED_BYTE, 1,
+        GX_TF_A8, &ogx_fast_conv_Alpha_A8 },
+};
+
+typedef struct {
+    const ConversionCase *c;
+    int size;
+    const void *src;
+    void *dst;
+    int dstpitch;
+} Job;
+
+static void run_fast(void *user_data)
+{
+    const Job *job = user_data;
+    FastConverter *conv = (FastConverter *)*job->c->fast_conv;
+    conv(job->src, job->c->type, job->size, job->size,
+         job->dst, 0, 0, job->dstpitch);
+}
+
+static void run_generic(void *user_data)
+{
+    const Job *job = user_data;
+    _ogx_bytes_to_texture_generic(job->src, job->c->format, job->c->type,
+                                  job->size, job->size,
+                                  job->dst, job->c->gx_format,
+                                  0, 0, job->dstpitch);
+}
+
+static void run_dxt1(void *user_data)
+{
+    const Job *job = user_data;
+    _ogx_convert_rgb_image_to_DXT1(job->src, job->dst,
+                                   job->size, job->size, 0);
+}
+
+static void fill_source(uint8_t *data, size_t size, GLenum type)
+{
+    if (type == GL_FLOAT) {
+        float *f = (float *)data;
+        for (size_t i = 0; i < size / sizeof(float); i++) {
+            f[i] = (rand() & 0xff) / 255.0f;
+        }
+    } else {
+        for (size_t i = 0; i < size; i++) {
+            data[i] = rand();
+        }
+    }
+}
+
+static double to_mbps(int size, int bytes_per_pixel, double seconds)
+{
+    return (double)size * size * bytes_per_pixel / seconds / (1024 * 1024);
+}
+
+static void run_case(const ConversionCase *c, int size)
+{
+    size_t src_size = (size_t)size * size * c->src_bytes_per_pixel;
+    uint8_t *src = malloc(src_size);
+    void *dst = memalign(32, GX_GetTexBufferSize(size, size, c->gx_format,
+                                                 GX_FALSE, 0));
+    if (!src || !dst) {
+        fprintf(stderr, "Out of memory for %dx%d\n", size, size);
+        exit(EXIT_FAILURE);
+    }
+    fill_source(src, src_size, c->type);
+
+    Job job = { c, size, src, dst, _ogx_pitch_for_width(c->gx_format, size) };
+
+    printf("%-40s %5dx%-5d", c->name, size, size);
+    if (c->gx_format == GX_TF_CMPR) {
+        /* Compressed textures have a single conversion path */
+        double dxt = bench_run(run_dxt1, &job);
+        printf(" %10s %10.1f\n", "-",
+               to_mbps(size, c->src_bytes_per_pixel, dxt));
+    } else {
+        double generic = bench_run(run_generic, &job);
+        double generic_mbps = to_mbps(size, c->src_bytes_per_pixel, generic);
+        if (c->fast_conv) {
+            double fast = bench_run(run_fast, &job);
+            printf(" %10.1f %10.1f %7.1fx\n",
+                   to_mbps(size, c->src_bytes_per_pixel, fast),
+                   generic_mbps, generic / fast);
+        } else {
+            printf(" %10s %10.1f\n", "-", generic_mbps);
+        }
+    }
+
+    free(dst);
+    free(src);
+}
+
+int main(int argc, char **argv)
+{
+    static const int default_sizes[] = { 64, 256, 1024 };
+    int num_sizes = argc > 1 ? argc - 1 : 3;
+    int sizes[num_sizes];
+    for (int i = 0; i < num_sizes; i++) {
+        sizes[i] = argc > 1 ? atoi(argv[i + 1]) : default_sizes[i];
+        /* GX textures are made of tiles of up to 8x8 texels */
+        if (sizes[i] <= 0 || sizes[i] % 8 != 0) {
+            fprintf(stderr, "Invalid size %s: must be a multiple of 8\n",
+                    argv[i + 1]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    ogx_initialize();
+
+    printf("%-40s %11s %10s %10s %8s\n", "Conversion", "Size",
+           "Fast MB/s", "Gen. MB/s", "Speedup");
+    for (int i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        for (int s = 0; s < num_sizes; s++) {
+            run_case(&s_cases[i], sizes[s]);
+        }
+    }
+    return EXIT_SUCCESS;
+}
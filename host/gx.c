@@ -0,0 +1,705 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include "gxhost.h"
+
+#include <ogc/gx.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Once the FIFO grows beyond this size it is rewound */
+#define FIFO_REWIND_SIZE (16 * 1024 * 1024)
+
+static GXHostBuffer s_fifo;
+static u64 s_fifo_rewound;
+static GXHostBuffer s_disp_list;
+
+GXHostBuffer *_gxhost_target = &s_fifo;
+u32 _gxhost_calls[GXHOST_CALL_COUNT];
+
+static const char *s_call_names[GXHOST_CALL_COUNT] = {
+#define GXHOST_CALL_NAME(name) "GX_" #name,
+    GXHOST_CALLS(GXHOST_CALL_NAME)
+#undef GXHOST_CALL_NAME
+};
+
+static GXHostVertexState s_vertex_state;
+
+static GXDrawSyncCallback s_draw_sync_cb;
+static u16 s_draw_sync_token;
+static bool s_deferred_sync;
+static bool s_inline_display_lists;
+static u16 *s_pending_tokens;
+static u32 s_pending_count;
+static u32 s_pending_capacity;
+
+void _gxhost_grow(GXHostBuffer *buffer, u32 needed)
+{
+    if (buffer->fixed) {
+        buffer->overflow = true;
+        return;
+    }
+
+    if (buffer == &s_fifo && buffer->size >= FIFO_REWIND_SIZE) {
+        s_fifo_rewound += buffer->size;
+        buffer->size = 0;
+        if (needed <= buffer->capacity) return;
+    }
+
+    u32 capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->size + needed) capacity *= 2;
+    buffer->data = realloc(buffer->data, capacity);
+    buffer->capacity = capacity;
+}
+
+void gxhost_reset()
+{
+    gxhost_fifo_clear();
+    gxhost_reset_call_counts();
+    memset(&s_vertex_state, 0, sizeof(s_vertex_state));
+    s_pending_count = 0;
+    s_deferred_sync = false;
+    s_inline_display_lists = false;
+}
+
+const u8 *gxhost_fifo_data()
+{
+    return s_fifo.data;
+}
+
+u32 gxhost_fifo_size()
+{
+    return s_fifo.size;
+}
+
+u64 gxhost_fifo_total()
+{
+    return s_fifo_rewound + s_fifo.size;
+}
+
+void gxhost_fifo_clear()
+{
+    s_fifo.size = 0;
+    s_fifo_rewound = 0;
+}
+
+u32 gxhost_call_count(GXHostCall call)
+{
+    return call < GXHOST_CALL_COUNT ? _gxhost_calls[call] : 0;
+}
+
+const char *gxhost_call_name(GXHostCall call)
+{
+    return call < GXHOST_CALL_COUNT ? s_call_names[call] : NULL;
+}
+
+void gxhost_reset_call_counts()
+{
+    memset(_gxhost_calls, 0, sizeof(_gxhost_calls));
+}
+
+const GXHostVertexState *gxhost_vertex_state()
+{
+    return &s_vertex_state;
+}
+
+static void retire_token(u16 token)
+{
+    s_draw_sync_token = token;
+    if (s_draw_sync_cb) s_draw_sync_cb(token);
+}
+
+void gxhost_set_deferred_sync(bool deferred)
+{
+    if (!deferred) gxhost_retire_all();
+    s_deferred_sync = deferred;
+}
+
+void gxhost_retire_all()
+{
+    for (u32 i = 0; i < s_pending_count; i++) {
+        retire_token(s_pending_tokens[i]);
+    }
+    s_pending_count = 0;
+}
+
+u32 gxhost_pending_syncs()
+{
+    return s_pending_count;
+}
+
+void GX_BeginDispList(void *list, u32 size)
+{
+    GXHOST_COUNT(BeginDispList);
+    s_disp_list.data = list;
+    s_disp_list.size = 0;
+    s_disp_list.capacity = size;
+    s_disp_list.fixed = true;
+    s_disp_list.overflow = false;
+    _gxhost_target = &s_disp_list;
+}
+
+u32 GX_EndDispList()
+{
+    GXHOST_COUNT(EndDispList);
+    /* Like libogc, pad the list to a multiple of 32 bytes */
+    while (s_disp_list.size % 32 != 0 && !s_disp_list.overflow) {
+        _gxhost_write_u8(GX_NOP);
+    }
+    _gxhost_target = &s_fifo;
+    return s_disp_list.overflow ? 0 : s_disp_list.size;
+}
+
+void gxhost_set_inline_display_lists(bool inline_lists)
+{
+    s_inline_display_lists = inline_lists;
+}
+
+void GX_CallDispList(const void *list, u32 nbytes)
+{
+    GXHOST_COUNT(CallDispList);
+    if (s_inline_display_lists) {
+        u8 *ptr = _gxhost_reserve(nbytes);
+        if (ptr) memcpy(ptr, list, nbytes);
+        return;
+    }
+    _gxhost_write_u8(GX_CALL_DL);
+    _gxhost_write_u32((u32)(uintptr_t)list);
+    _gxhost_write_u32(nbytes);
+}
+
+void GX_SetArray(u32 attr, const void *ptr, u8 stride)
+{
+    GXHOST_COUNT(SetArray);
+    if (attr >= GX_VA_MAXATTR) return;
+    s_vertex_state.arrays[attr].data = ptr;
+    s_vertex_state.arrays[attr].stride = stride;
+}
+
+void GX_SetVtxDesc(u8 attr, u8 type)
+{
+    GXHOST_COUNT(SetVtxDesc);
+    if (attr >= GX_VA_MAXATTR) return;
+    s_vertex_state.vtx_desc[attr] = type;
+}
+
+void GX_SetVtxAttrFmt(u8 vtxfmt, u32 vtxattr, u32 comptype, u32 compsize,
+                      u32 frac)
+{
+    GXHOST_COUNT(SetVtxAttrFmt);
+    if (vtxfmt >= GX_MAXVTXFMT || vtxattr >= GX_VA_MAXATTR) return;
+    s_vertex_state.vtx_attr_fmt[vtxfmt][vtxattr].comptype = comptype;
+    s_vertex_state.vtx_attr_fmt[vtxfmt][vtxattr].compsize = compsize;
+    s_vertex_state.vtx_attr_fmt[vtxfmt][vtxattr].frac = frac;
+}
+
+void GX_ClearVtxDesc()
+{
+    GXHOST_COUNT(ClearVtxDesc);
+    memset(s_vertex_state.vtx_desc, 0, sizeof(s_vertex_state.vtx_desc));
+}
+
+void GX_InvVtxCache()
+{
+    GXHOST_COUNT(InvVtxCache);
+}
+
+void GX_SetCurrentMtx(u32 mtx)
+{
+    GXHOST_COUNT(SetCurrentMtx);
+    s_vertex_state.current_mtx = mtx;
+}
+
+/* Matrix loads are encoded as XF register loads, like on the hardware */
+static void write_xf_header(u32 address, u32 count)
+{
+    _gxhost_write_u8(GX_LOAD_XF_REG);
+    _gxhost_write_u32(((count - 1) << 16) | address);
+}
+
+void GX_LoadPosMtxImm(const Mtx mt, u32 pnidx)
+{
+    GXHOST_COUNT(LoadPosMtxImm);
+    write_xf_header(pnidx * 4, 12);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            _gxhost_write_f32(mt[i][j]);
+}
+
+void GX_LoadNrmMtxImm(const Mtx mt, u32 pnidx)
+{
+    GXHOST_COUNT(LoadNrmMtxImm);
+    write_xf_header(0x400 + pnidx * 3, 9);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            _gxhost_write_f32(mt[i][j]);
+}
+
+void GX_LoadTexMtxImm(const Mtx mt, u32 texidx, u8 type)
+{
+    GXHOST_COUNT(LoadTexMtxImm);
+    int rows = type == GX_MTX2x4 ? 2 : 3;
+    u32 address = texidx >= GX_DTTMTX0 ?
+        0x500 + (texidx - GX_DTTMTX0) * 4 : texidx * 4;
+    write_xf_header(address, rows * 4);
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < 4; j++)
+            _gxhost_write_f32(mt[i][j]);
+}
+
+void GX_LoadProjectionMtx(const Mtx44 mt, u8 type)
+{
+    GXHOST_COUNT(LoadProjectionMtx);
+    write_xf_header(0x1020, 7);
+    _gxhost_write_f32(mt[0][0]);
+    _gxhost_write_f32(type == GX_PERSPECTIVE ? mt[0][2] : mt[0][3]);
+    _gxhost_write_f32(mt[1][1]);
+    _gxhost_write_f32(type == GX_PERSPECTIVE ? mt[1][2] : mt[1][3]);
+    _gxhost_write_f32(mt[2][2]);
+    _gxhost_write_f32(mt[2][3]);
+    _gxhost_write_u32(type);
+}
+
+/* Register writes are encoded as BP register loads: the register is the
+ * GXHostCall of the function, and the value holds the index of the unit
+ * being programmed (for the functions taking one, 0 otherwise) in the upper
+ * 8 bits and a hash of all the parameters in the lower 16 bits. */
+static u32 hash_bytes(u32 hash, const void *data, size_t size)
+{
+    const u8 *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void write_bp_reg(GXHostCall call, u8 index, u32 hash)
+{
+    _gxhost_write_u8(GX_LOAD_BP_REG);
+    _gxhost_write_u32((call << 24) | (index << 16) |
+                      ((hash ^ (hash >> 16)) & 0xffff));
+}
+
+#define HASH_INIT 2166136261u
+#define HASH_ARG(arg) hash = hash_bytes(hash, &(arg), sizeof(arg));
+#define FOR_EACH_1(f, a) f(a)
+#define FOR_EACH_2(f, a, ...) f(a) FOR_EACH_1(f, __VA_ARGS__)
+#define FOR_EACH_3(f, a, ...) f(a) FOR_EACH_2(f, __VA_ARGS__)
+#define FOR_EACH_4(f, a, ...) f(a) FOR_EACH_3(f, __VA_ARGS__)
+#define FOR_EACH_5(f, a, ...) f(a) FOR_EACH_4(f, __VA_ARGS__)
+#define FOR_EACH_6(f, a, ...) f(a) FOR_EACH_5(f, __VA_ARGS__)
+#define FOR_EACH_7(f, a, ...) f(a) FOR_EACH_6(f, __VA_ARGS__)
+#define FOR_EACH_N(_1, _2, _3, _4, _5, _6, _7, n, ...) FOR_EACH_##n
+#define FOR_EACH(f, ...) \
+    FOR_EACH_N(__VA_ARGS__, 7, 6, 5, 4, 3, 2, 1, 0)(f, __VA_ARGS__)
+
+/* Setters of the global state; the arguments are given again after the
+ * parameter list, to compute the hash */
+#define STATE_SETTER(name, params, ...) \
+    void GX_##name params { \
+        GXHOST_COUNT(name); \
+        u32 hash = HASH_INIT; \
+        FOR_EACH(HASH_ARG, __VA_ARGS__) \
+        write_bp_reg(GXHOST_CALL_##name, 0, hash); \
+    }
+
+/* Setters of the state of a unit (TEV stage, channel, etc.), given by the
+ * first parameter */
+#define UNIT_STATE_SETTER(name, params, unit, ...) \
+    void GX_##name params { \
+        GXHOST_COUNT(name); \
+        u32 hash = HASH_INIT; \
+        HASH_ARG(unit) \
+        FOR_EACH(HASH_ARG, __VA_ARGS__) \
+        write_bp_reg(GXHOST_CALL_##name, unit, hash); \
+    }
+
+/* Commands which don't take parameters */
+#define COMMAND(name) \
+    void GX_##name(void) { \
+        GXHOST_COUNT(name); \
+        write_bp_reg(GXHOST_CALL_##name, 0, 0); \
+    }
+
+STATE_SETTER(SetViewport, (f32 xOrig, f32 yOrig, f32 wd, f32 ht, f32 nearZ,
+                           f32 farZ), xOrig, yOrig, wd, ht, nearZ, farZ)
+STATE_SETTER(SetScissor, (u32 xOrigin, u32 yOrigin, u32 wd, u32 ht),
+    xOrigin, yOrigin, wd, ht)
+STATE_SETTER(SetCullMode, (u8 mode), mode)
+STATE_SETTER(SetZMode, (u8 enable, u8 func, u8 update_enable),
+    enable, func, update_enable)
+STATE_SETTER(SetZCompLoc, (u8 before_tex), before_tex)
+STATE_SETTER(SetZTexture, (u8 op, u8 fmt, u32 bias), op, fmt, bias)
+STATE_SETTER(SetAlphaCompare, (u8 comp0, u8 ref0, u8 aop, u8 comp1, u8 ref1),
+    comp0, ref0, aop, comp1, ref1)
+STATE_SETTER(SetAlphaUpdate, (u8 enable), enable)
+STATE_SETTER(SetColorUpdate, (u8 enable), enable)
+STATE_SETTER(SetBlendMode, (u8 type, u8 src_fact, u8 dst_fact, u8 op),
+    type, src_fact, dst_fact, op)
+STATE_SETTER(SetFog, (u8 type, f32 startz, f32 endz, f32 nearz, f32 farz,
+                      GXColor col), type, startz, endz, nearz, farz, col)
+STATE_SETTER(SetPixelFmt, (u8 pix_fmt, u8 z_fmt), pix_fmt, z_fmt)
+STATE_SETTER(SetDispCopyGamma, (u8 gamma), gamma)
+STATE_SETTER(SetLineWidth, (u8 width, u8 fmt), width, fmt)
+STATE_SETTER(SetPointSize, (u8 width, u8 fmt), width, fmt)
+UNIT_STATE_SETTER(EnableTexOffsets, (u8 coord, u8 line_enable,
+                                     u8 point_enable),
+    coord, line_enable, point_enable)
+STATE_SETTER(SetNumChans, (u8 num), num)
+STATE_SETTER(SetNumTexGens, (u32 nr), nr)
+STATE_SETTER(SetNumTevStages, (u8 num), num)
+UNIT_STATE_SETTER(SetChanCtrl, (s32 channel, u8 enable, u8 ambsrc, u8 matsrc,
+                                u8 litmask, u8 diff_fn, u8 attn_fn),
+    channel, enable, ambsrc, matsrc, litmask, diff_fn, attn_fn)
+UNIT_STATE_SETTER(SetChanAmbColor, (s32 channel, GXColor color),
+    channel, color)
+UNIT_STATE_SETTER(SetChanMatColor, (s32 channel, GXColor color),
+    channel, color)
+UNIT_STATE_SETTER(SetTevOp, (u8 tevstage, u8 mode), tevstage, mode)
+UNIT_STATE_SETTER(SetTevOrder, (u8 tevstage, u8 texcoord, u32 texmap,
+                                u8 color), tevstage, texcoord, texmap, color)
+UNIT_STATE_SETTER(SetTevColorIn, (u8 tevstage, u8 a, u8 b, u8 c, u8 d),
+    tevstage, a, b, c, d)
+UNIT_STATE_SETTER(SetTevAlphaIn, (u8 tevstage, u8 a, u8 b, u8 c, u8 d),
+    tevstage, a, b, c, d)
+UNIT_STATE_SETTER(SetTevColorOp, (u8 tevstage, u8 tevop, u8 tevbias,
+                                  u8 tevscale, u8 clamp, u8 tevregid),
+    tevstage, tevop, tevbias, tevscale, clamp, tevregid)
+UNIT_STATE_SETTER(SetTevAlphaOp, (u8 tevstage, u8 tevop, u8 tevbias,
+                                  u8 tevscale, u8 clamp, u8 tevregid),
+    tevstage, tevop, tevbias, tevscale, clamp, tevregid)
+UNIT_STATE_SETTER(SetTevColor, (u8 tev_regid, GXColor color), tev_regid, color)
+UNIT_STATE_SETTER(SetTevKColor, (u8 sel, GXColor col), sel, col)
+UNIT_STATE_SETTER(SetTevKColorSel, (u8 tevstage, u8 sel), tevstage, sel)
+UNIT_STATE_SETTER(SetTevKAlphaSel, (u8 tevstage, u8 sel), tevstage, sel)
+COMMAND(InvalidateTexAll)
+STATE_SETTER(SetTexCopySrc, (u16 left, u16 top, u16 wd, u16 ht),
+    left, top, wd, ht)
+STATE_SETTER(SetTexCopyDst, (u16 wd, u16 ht, u32 fmt, u8 mipmap),
+    wd, ht, fmt, mipmap)
+STATE_SETTER(CopyTex, (void *dest, u8 clear), dest, clear)
+COMMAND(PixModeSync)
+COMMAND(ClearBoundingBox)
+
+void GX_SetCopyFilter(u8 aa, u8 sample_pattern[12][2], u8 vf, u8 vfilter[7])
+{
+    GXHOST_COUNT(SetCopyFilter);
+    u32 hash = HASH_INIT;
+    HASH_ARG(aa)
+    HASH_ARG(vf)
+    if (sample_pattern) hash = hash_bytes(hash, sample_pattern, 12 * 2);
+    if (vfilter) hash = hash_bytes(hash, vfilter, 7);
+    write_bp_reg(GXHOST_CALL_SetCopyFilter, 0, hash);
+}
+
+void GX_SetTexCoordGen2(u16 texcoord, u32 tgen_typ, u32 tgen_src,
+                        u32 mtxsrc, u32 normalize, u32 postmtx)
+{
+    GXHOST_COUNT(SetTexCoordGen);
+    u32 hash = HASH_INIT;
+    FOR_EACH(HASH_ARG, texcoord, tgen_typ, tgen_src, mtxsrc, normalize, postmtx)
+    write_bp_reg(GXHOST_CALL_SetTexCoordGen, texcoord, hash);
+}
+
+void GX_ReadBoundingBox(u16 *top, u16 *bottom, u16 *left, u16 *right)
+{
+    GXHOST_COUNT(ReadBoundingBox);
+    *top = *bottom = *left = *right = 0;
+}
+
+void GX_InitLightPos(GXLightObj *lit_obj, f32 x, f32 y, f32 z)
+{
+    lit_obj->pos[0] = x;
+    lit_obj->pos[1] = y;
+    lit_obj->pos[2] = z;
+}
+
+void GX_InitLightDir(GXLightObj *lit_obj, f32 nx, f32 ny, f32 nz)
+{
+    lit_obj->dir[0] = -nx;
+    lit_obj->dir[1] = -ny;
+    lit_obj->dir[2] = -nz;
+}
+
+void GX_InitLightColor(GXLightObj *lit_obj, GXColor col)
+{
+    lit_obj->color = col;
+}
+
+void GX_InitLightAttn(GXLightObj *lit_obj, f32 a0, f32 a1, f32 a2,
+                      f32 k0, f32 k1, f32 k2)
+{
+    lit_obj->attn_a[0] = a0;
+    lit_obj->attn_a[1] = a1;
+    lit_obj->attn_a[2] = a2;
+    lit_obj->attn_k[0] = k0;
+    lit_obj->attn_k[1] = k1;
+    lit_obj->attn_k[2] = k2;
+}
+
+void GX_InitSpecularDir(GXLightObj *lit_obj, f32 nx, f32 ny, f32 nz)
+{
+    /* The half-angle computation is not relevant for the host */
+    lit_obj->pos[0] = -nx * 1048576.0f;
+    lit_obj->pos[1] = -ny * 1048576.0f;
+    lit_obj->pos[2] = -nz * 1048576.0f;
+    GX_InitLightDir(lit_obj, nx, ny, nz);
+}
+
+void GX_LoadLightObj(GXLightObj *lit_obj, u8 lit_id)
+{
+    GXHOST_COUNT(LoadLightObj);
+    u32 hash = hash_bytes(HASH_INIT, lit_obj, sizeof(*lit_obj));
+    write_bp_reg(GXHOST_CALL_LoadLightObj, lit_id, hash);
+}
+
+u32 GX_GetTexBufferSize(u16 wd, u16 ht, u32 fmt, u8 mipmap, u8 maxlod)
+{
+    u32 xshift, yshift;
+
+    switch (fmt) {
+    case GX_TF_I4:
+    case GX_TF_CI4:
+    case GX_TF_CMPR:
+    case GX_CTF_R4:
+        xshift = 3;
+        yshift = 3;
+        break;
+    case GX_TF_I8:
+    case GX_TF_IA4:
+    case GX_TF_CI8:
+    case GX_TF_Z8:
+    case GX_CTF_RA4:
+    case GX_CTF_A8:
+    case GX_CTF_R8:
+    case GX_CTF_G8:
+    case GX_CTF_B8:
+        xshift = 3;
+        yshift = 2;
+        break;
+    case GX_TF_IA8:
+    case GX_TF_CI14:
+    case GX_TF_RGB565:
+    case GX_TF_RGB5A3:
+    case GX_TF_RGBA8:
+    case GX_TF_Z16:
+    case GX_TF_Z24X8:
+    case GX_CTF_RA8:
+    case GX_CTF_RG8:
+    case GX_CTF_GB8:
+        xshift = 2;
+        yshift = 2;
+        break;
+    default:
+        xshift = 0;
+        yshift = 0;
+    }
+
+    /* Size of a tile, in bytes */
+    u32 tile_size =
+        (fmt == GX_TF_RGBA8 || fmt == GX_TF_Z24X8) ? 64 : 32;
+    u32 levels = mipmap ? maxlod : 1;
+    u32 w = wd, h = ht, size = 0;
+    while (levels-- > 0) {
+        u32 xtiles = (w + (1 << xshift) - 1) >> xshift;
+        u32 ytiles = (h + (1 << yshift) - 1) >> yshift;
+        size += xtiles * ytiles * tile_size;
+        if (w == 1 && h == 1) break;
+        if (w > 1) w >>= 1;
+        if (h > 1) h >>= 1;
+    }
+    return size;
+}
+
+void GX_InitTexObj(GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt,
+                   u8 wrap_s, u8 wrap_t, u8 mipmap)
+{
+    memset(obj, 0, sizeof(*obj));
+    obj->data = img_ptr;
+    obj->width = wd;
+    obj->height = ht;
+    obj->format = fmt;
+    obj->wrap_s = wrap_s;
+    obj->wrap_t = wrap_t;
+    obj->mipmap = mipmap;
+    obj->min_filter = mipmap ? GX_LIN_MIP_LIN : GX_LINEAR;
+    obj->mag_filter = GX_LINEAR;
+    obj->max_lod = mipmap ? 10.0f : 0.0f;
+}
+
+void GX_InitTexObjLOD(GXTexObj *obj, u8 minfilt, u8 magfilt, f32 minlod,
+                      f32 maxlod, f32 lodbias, u8 biasclamp, u8 edgelod,
+                      u8 maxaniso)
+{
+    obj->min_filter = minfilt;
+    obj->mag_filter = magfilt;
+    obj->min_lod = minlod;
+    obj->max_lod = maxlod;
+    obj->lod_bias = lodbias;
+    obj->bias_clamp = biasclamp;
+    obj->edge_lod = edgelod;
+    obj->max_aniso = maxaniso;
+}
+
+void GX_InitTexObjFilterMode(GXTexObj *obj, u8 minfilt, u8 magfilt)
+{
+    obj->min_filter = minfilt;
+    obj->mag_filter = magfilt;
+}
+
+void GX_InitTexObjWrapMode(GXTexObj *obj, u8 wrap_s, u8 wrap_t)
+{
+    obj->wrap_s = wrap_s;
+    obj->wrap_t = wrap_t;
+}
+
+void GX_InitTexObjUserData(GXTexObj *obj, void *userdata)
+{
+    obj->user_data = userdata;
+}
+
+void GX_GetTexObjAll(const GXTexObj *obj, void **image_ptr, u16 *width,
+                     u16 *height, u8 *format, u8 *wrap_s, u8 *wrap_t,
+                     u8 *mipmap)
+{
+    *image_ptr = obj->data;
+    *width = obj->width;
+    *height = obj->height;
+    *format = obj->format;
+    *wrap_s = obj->wrap_s;
+    *wrap_t = obj->wrap_t;
+    *mipmap = obj->mipmap;
+}
+
+void *GX_GetTexObjData(const GXTexObj *obj)
+{
+    return obj->data;
+}
+
+u16 GX_GetTexObjWidth(const GXTexObj *obj)
+{
+    return obj->width;
+}
+
+u16 GX_GetTexObjHeight(const GXTexObj *obj)
+{
+    return obj->height;
+}
+
+u32 GX_GetTexObjFmt(const GXTexObj *obj)
+{
+    return obj->format;
+}
+
+u8 GX_GetTexObjWrapS(const GXTexObj *obj)
+{
+    return obj->wrap_s;
+}
+
+u8 GX_GetTexObjWrapT(const GXTexObj *obj)
+{
+    return obj->wrap_t;
+}
+
+void GX_GetTexObjFilterMode(const GXTexObj *obj, u8 *minfilt, u8 *magfilt)
+{
+    *minfilt = obj->min_filter;
+    *magfilt = obj->mag_filter;
+}
+
+void GX_GetTexObjLOD(const GXTexObj *obj, f32 *minlod, f32 *maxlod)
+{
+    *minlod = obj->min_lod;
+    *maxlod = obj->max_lod;
+}
+
+void *GX_GetTexObjUserData(const GXTexObj *obj)
+{
+    return obj->user_data;
+}
+
+void GX_LoadTexObj(const GXTexObj *obj, u8 mapid)
+{
+    GXHOST_COUNT(LoadTexObj);
+    u32 hash = hash_bytes(HASH_INIT, obj, sizeof(*obj));
+    write_bp_reg(GXHOST_CALL_LoadTexObj, mapid, hash);
+}
+
+void GX_SetDrawSync(u16 token)
+{
+    GXHOST_COUNT(SetDrawSync);
+    if (!s_deferred_sync) {
+        retire_token(token);
+        return;
+    }
+
+    if (s_pending_count == s_pending_capacity) {
+        s_pending_capacity = s_pending_capacity ? s_pending_capacity * 2 : 64;
+        s_pending_tokens = realloc(s_pending_tokens,
+                                   s_pending_capacity * sizeof(u16));
+    }
+    s_pending_tokens[s_pending_count++] = token;
+}
+
+u16 GX_GetDrawSync()
+{
+    GXHOST_COUNT(GetDrawSync);
+    /* Let the "GPU" make some progress */
+    if (s_pending_count > 0) {
+        retire_token(s_pending_tokens[0]);
+        s_pending_count--;
+        memmove(s_pending_tokens, s_pending_tokens + 1,
+                s_pending_count * sizeof(u16));
+    }
+    return s_draw_sync_token;
+}
+
+GXDrawSyncCallback GX_SetDrawSyncCallback(GXDrawSyncCallback cb)
+{
+    GXDrawSyncCallback old = s_draw_sync_cb;
+    s_draw_sync_cb = cb;
+    return old;
+}
+
+void GX_SetDrawDone()
+{
+    GXHOST_COUNT(SetDrawDone);
+}
+
+void GX_WaitDrawDone()
+{
+    GXHOST_COUNT(WaitDrawDone);
+    gxhost_retire_all();
+}
+
+void GX_DrawDone()
+{
+    GXHOST_COUNT(DrawDone);
+    gxhost_retire_all();
+}
@@ -0,0 +1,194 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Recording backend used when building opengx for the host.
+ *
+ * The GX functions declared in <ogc/gx.h> do not talk to any hardware: the
+ * data that libogc would write into the GP FIFO (primitive headers, vertex
+ * data, display list calls and XF matrix loads) is appended to an in-memory
+ * buffer, in the same big-endian layout that the GPU would see. Functions
+ * which program GPU registers are encoded as BP register loads (opcode 0x61)
+ * whose 32 bits are not the hardware ones: the top 8 bits hold the GXHostCall
+ * of the function, the next 8 bits the TEV stage, channel, texture map or
+ * other unit it programs (0 for global state), and the low 16 bits a hash of
+ * all of its parameters. Besides, every GX entry point keeps a call counter,
+ * which can be queried to verify how many state changes a given operation
+ * caused.
+ *
+ * The GPU is considered infinitely fast: draw sync tokens are retired as soon
+ * as they are sent, unless gxhost_set_deferred_sync() is used.
+ */
+
+#ifndef GXHOST_H
+#define GXHOST_H
+
+#include <gctypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GXHOST_CALLS(X) \
+    X(Begin) X(End) X(BeginDispList) X(EndDispList) X(CallDispList) \
+    X(SetArray) X(SetVtxDesc) X(SetVtxAttrFmt) X(ClearVtxDesc) \
+    X(InvVtxCache) X(SetCurrentMtx) X(LoadPosMtxImm) X(LoadNrmMtxImm) \
+    X(LoadTexMtxImm) X(LoadProjectionMtx) X(SetViewport) X(SetScissor) \
+    X(SetCullMode) X(SetZMode) X(SetZCompLoc) X(SetZTexture) \
+    X(SetAlphaCompare) X(SetAlphaUpdate) X(SetColorUpdate) X(SetBlendMode) \
+    X(SetFog) X(SetPixelFmt) X(SetDispCopyGamma) X(SetLineWidth) \
+    X(SetPointSize) X(EnableTexOffsets) X(SetNumChans) X(SetNumTexGens) \
+    X(SetNumTevStages) X(SetChanCtrl) X(SetChanAmbColor) X(SetChanMatColor) \
+    X(SetTevOp) X(SetTevOrder) X(SetTevColorIn) X(SetTevAlphaIn) \
+    X(SetTevColorOp) X(SetTevAlphaOp) X(SetTevColor) X(SetTevKColor) \
+    X(SetTevKColorSel) X(SetTevKAlphaSel) X(SetTexCoordGen) X(LoadTexObj) \
+    X(InvalidateTexAll) X(LoadLightObj) X(SetTexCopySrc) X(SetTexCopyDst) \
+    X(CopyTex) X(SetCopyFilter) X(PixModeSync) X(ClearBoundingBox) \
+    X(ReadBoundingBox) X(SetDrawSync) X(GetDrawSync) X(SetDrawDone) \
+    X(WaitDrawDone) X(DrawDone) X(DCFlushRange) X(DCInvalidateRange) \
+    X(DCStoreRange)
+
+typedef enum {
+#define GXHOST_CALL_ENUM(name) GXHOST_CALL_##name,
+    GXHOST_CALLS(GXHOST_CALL_ENUM)
+#undef GXHOST_CALL_ENUM
+    GXHOST_CALL_COUNT
+} GXHostCall;
+
+typedef struct {
+    u8 *data;
+    u32 size;
+    u32 capacity;
+    /* If set, the buffer cannot grow (this is the case for display lists) */
+    bool fixed;
+    bool overflow;
+} GXHostBuffer;
+
+/* A snapshot of the vertex-related GX state, for inspection by tests and
+ * benchmarks. */
+typedef struct {
+    u8 vtx_desc[26]; /* indexed by GX_VA_* */
+    struct {
+        u8 comptype;
+        u8 compsize;
+        u8 frac;
+    } vtx_attr_fmt[8][26]; /* indexed by GX_VTXFMT*, GX_VA_* */
+    struct {
+        const void *data;
+        u8 stride;
+    } arrays[26];
+    u32 current_mtx;
+} GXHostVertexState;
+
+/* Not for direct use: these are accessed by the inline functions in
+ * <ogc/gx.h> */
+extern GXHostBuffer *_gxhost_target;
+extern u32 _gxhost_calls[GXHOST_CALL_COUNT];
+void _gxhost_grow(GXHostBuffer *buffer, u32 needed);
+
+#define GXHOST_COUNT(name) _gxhost_calls[GXHOST_CALL_##name]++
+
+static inline u8 *_gxhost_reserve(u32 bytes)
+{
+    GXHostBuffer *b = _gxhost_target;
+    if (__builtin_expect(b->size + bytes > b->capacity, 0)) {
+        _gxhost_grow(b, bytes);
+        /* Display lists don't grow; writes past their end are dropped */
+        if (b->size + bytes > b->capacity) return NULL;
+    }
+    u8 *ptr = b->data + b->size;
+    b->size += bytes;
+    return ptr;
+}
+
+static inline void _gxhost_write_u8(u8 value)
+{
+    u8 *ptr = _gxhost_reserve(1);
+    if (ptr) ptr[0] = value;
+}
+
+static inline void _gxhost_write_u16(u16 value)
+{
+    u8 *ptr = _gxhost_reserve(2);
+    if (!ptr) return;
+    ptr[0] = value >> 8;
+    ptr[1] = value;
+}
+
+static inline void _gxhost_write_u32(u32 value)
+{
+    u8 *ptr = _gxhost_reserve(4);
+    if (!ptr) return;
+    ptr[0] = value >> 24;
+    ptr[1] = value >> 16;
+    ptr[2] = value >> 8;
+    ptr[3] = value;
+}
+
+static inline void _gxhost_write_f32(f32 value)
+{
+    union { f32 f; u32 u; } v = { value };
+    _gxhost_write_u32(v.u);
+}
+
+/* Resets the recorded FIFO data, the call counters and the draw sync state */
+void gxhost_reset(void);
+
+/* The data written to the GP FIFO since the last reset. Note that the FIFO
+ * is rewound when it grows beyond a few megabytes, to avoid an unbounded
+ * memory growth in benchmarks; gxhost_fifo_total() returns the total number
+ * of bytes written, regardless of rewinds. */
+const u8 *gxhost_fifo_data(void);
+u32 gxhost_fifo_size(void);
+u64 gxhost_fifo_total(void);
+void gxhost_fifo_clear(void);
+
+u32 gxhost_call_count(GXHostCall call);
+const char *gxhost_call_name(GXHostCall call);
+void gxhost_reset_call_counts(void);
+
+const GXHostVertexState *gxhost_vertex_state(void);
+
+/* When deferred sync is enabled, the tokens sent with GX_SetDrawSync() are
+ * not retired immediately: they are queued and retired one by one at each
+ * call to GX_GetDrawSync() (as if the GPU made some progress while the CPU
+ * was polling) or all at once by GX_DrawDone() and gxhost_retire_all(). */
+void gxhost_set_deferred_sync(bool deferred);
+void gxhost_retire_all(void);
+/* Number of tokens sent but not yet retired */
+u32 gxhost_pending_syncs(void);
+
+/* When enabled, GX_CallDispList() appends the contents of the display list to
+ * the FIFO, as if the GPU had executed it, instead of the call command. */
+void gxhost_set_inline_display_lists(bool inline_lists);
+
+#ifdef __cplusplus
+} // extern C
+#endif
+
+#endif /* GXHOST_H */
@@ -0,0 +1,71 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Host-side replacement for libogc's cache.h. On the host there are no
+ * incoherent caches to manage, so these functions only count their calls. */
+
+#ifndef GXHOST_CACHE_H
+#define GXHOST_CACHE_H
+
+#include <gxhost.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline void DCFlushRange(void *startaddress, u32 len)
+{
+    GXHOST_COUNT(DCFlushRange);
+}
+
+static inline void DCInvalidateRange(void *startaddress, u32 len)
+{
+    GXHOST_COUNT(DCInvalidateRange);
+}
+
+static inline void DCStoreRange(void *startaddress, u32 len)
+{
+    GXHOST_COUNT(DCStoreRange);
+}
+
+static inline void DCFlushRangeNoSync(void *startaddress, u32 len)
+{
+    GXHOST_COUNT(DCFlushRange);
+}
+
+static inline void DCStoreRangeNoSync(void *startaddress, u32 len)
+{
+    GXHOST_COUNT(DCStoreRange);
+}
+
+#ifdef __cplusplus
+} // extern C
+#endif
+
+#endif /* GXHOST_CACHE_H */
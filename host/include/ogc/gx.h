@@ -0,0 +1,888 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Host-side replacement for libogc's gx.h.
+ *
+ * Constant values match the ones from libogc, so that code which relies on
+ * them (for example, by patching display lists) behaves as on the console.
+ * See <gxhost.h> for a description of what gets recorded.
+ */
+
+#ifndef GXHOST_GX_H
+#define GXHOST_GX_H
+
+#include <gctypes.h>
+#include <gxhost.h>
+#include <ogc/gu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GX_FALSE 0
+#define GX_TRUE 1
+#define GX_DISABLE 0
+#define GX_ENABLE 1
+
+#define GX_NOP 0x00
+#define GX_LOAD_XF_REG 0x10
+#define GX_CALL_DL 0x40
+#define GX_LOAD_BP_REG 0x61
+
+/* Primitives */
+#define GX_QUADS 0x80
+#define GX_TRIANGLES 0x90
+#define GX_TRIANGLESTRIP 0x98
+#define GX_TRIANGLEFAN 0xA0
+#define GX_LINES 0xA8
+#define GX_LINESTRIP 0xB0
+#define GX_POINTS 0xB8
+
+#define GX_VTXFMT0 0
+#define GX_VTXFMT1 1
+#define GX_VTXFMT2 2
+#define GX_VTXFMT3 3
+#define GX_VTXFMT4 4
+#define GX_VTXFMT5 5
+#define GX_VTXFMT6 6
+#define GX_VTXFMT7 7
+#define GX_MAXVTXFMT 8
+
+/* Vertex attributes */
+#define GX_VA_PTNMTXIDX 0
+#define GX_VA_TEX0MTXIDX 1
+#define GX_VA_TEX1MTXIDX 2
+#define GX_VA_TEX2MTXIDX 3
+#define GX_VA_TEX3MTXIDX 4
+#define GX_VA_TEX4MTXIDX 5
+#define GX_VA_TEX5MTXIDX 6
+#define GX_VA_TEX6MTXIDX 7
+#define GX_VA_TEX7MTXIDX 8
+#define GX_VA_POS 9
+#define GX_VA_NRM 10
+#define GX_VA_CLR0 11
+#define GX_VA_CLR1 12
+#define GX_VA_TEX0 13
+#define GX_VA_TEX1 14
+#define GX_VA_TEX2 15
+#define GX_VA_TEX3 16
+#define GX_VA_TEX4 17
+#define GX_VA_TEX5 18
+#define GX_VA_TEX6 19
+#define GX_VA_TEX7 20
+#define GX_POSMTXARRAY 21
+#define GX_NRMMTXARRAY 22
+#define GX_TEXMTXARRAY 23
+#define GX_LIGHTARRAY 24
+#define GX_VA_NBT 25
+#define GX_VA_MAXATTR 26
+#define GX_VA_NULL 0xff
+
+/* Vertex input modes */
+#define GX_NONE 0
+#define GX_DIRECT 1
+#define GX_INDEX8 2
+#define GX_INDEX16 3
+
+/* Component types */
+#define GX_U8 0
+#define GX_S8 1
+#define GX_U16 2
+#define GX_S16 3
+#define GX_F32 4
+#define GX_RGB565 0
+#define GX_RGB8 1
+#define GX_RGBX8 2
+#define GX_RGBA4 3
+#define GX_RGBA6 4
+#define GX_RGBA8 5
+
+#define GX_POS_XY 0
+#define GX_POS_XYZ 1
+#define GX_NRM_XYZ 0
+#define GX_NRM_NBT 1
+#define GX_NRM_NBT3 2
+#define GX_CLR_RGB 0
+#define GX_CLR_RGBA 1
+#define GX_TEX_S 0
+#define GX_TEX_ST 1
+
+/* Comparison functions */
+#define GX_NEVER 0
+#define GX_LESS 1
+#define GX_EQUAL 2
+#define GX_LEQUAL 3
+#define GX_GREATER 4
+#define GX_NEQUAL 5
+#define GX_GEQUAL 6
+#define GX_ALWAYS 7
+
+#define GX_AOP_AND 0
+#define GX_AOP_OR 1
+#define GX_AOP_XOR 2
+#define GX_AOP_XNOR 3
+
+/* Blending */
+#define GX_BM_NONE 0
+#define GX_BM_BLEND 1
+#define GX_BM_LOGIC 2
+#define GX_BM_SUBTRACT 3
+
+#define GX_BL_ZERO 0
+#define GX_BL_ONE 1
+#define GX_BL_SRCCLR 2
+#define GX_BL_INVSRCCLR 3
+#define GX_BL_SRCALPHA 4
+#define GX_BL_INVSRCALPHA 5
+#define GX_BL_DSTALPHA 6
+#define GX_BL_INVDSTALPHA 7
+#define GX_BL_DSTCLR GX_BL_SRCCLR
+#define GX_BL_INVDSTCLR GX_BL_INVSRCCLR
+
+#define GX_LO_CLEAR 0
+#define GX_LO_AND 1
+#define GX_LO_REVAND 2
+#define GX_LO_COPY 3
+#define GX_LO_INVAND 4
+#define GX_LO_NOOP 5
+#define GX_LO_XOR 6
+#define GX_LO_OR 7
+#define GX_LO_NOR 8
+#define GX_LO_EQUIV 9
+#define GX_LO_INV 10
+#define GX_LO_REVOR 11
+#define GX_LO_INVCOPY 12
+#define GX_LO_INVOR 13
+#define GX_LO_NAND 14
+#define GX_LO_SET 15
+
+#define GX_CULL_NONE 0
+#define GX_CULL_FRONT 1
+#define GX_CULL_BACK 2
+#define GX_CULL_ALL 3
+
+/* Matrices */
+#define GX_PNMTX0 0
+#define GX_PNMTX1 3
+#define GX_PNMTX2 6
+#define GX_PNMTX3 9
+#define GX_PNMTX4 12
+#define GX_PNMTX5 15
+#define GX_PNMTX6 18
+#define GX_PNMTX7 21
+#define GX_PNMTX8 24
+#define GX_PNMTX9 27
+#define GX_TEXMTX0 30
+#define GX_TEXMTX1 33
+#define GX_TEXMTX2 36
+#define GX_TEXMTX3 39
+#define GX_TEXMTX4 42
+#define GX_TEXMTX5 45
+#define GX_TEXMTX6 48
+#define GX_TEXMTX7 51
+#define GX_TEXMTX8 54
+#define GX_TEXMTX9 57
+#define GX_IDENTITY 60
+#define GX_DTTMTX0 64
+#define GX_DTTIDENTITY 125
+
+#define GX_PERSPECTIVE 0
+#define GX_ORTHOGRAPHIC 1
+
+#define GX_MTX3x4 0
+#define GX_MTX2x4 1
+
+/* Texture coordinate generation */
+#define GX_TG_MTX3x4 0
+#define GX_TG_MTX2x4 1
+#define GX_TG_BUMP0 2
+#define GX_TG_SRTG 10
+
+#define GX_TG_POS 0
+#define GX_TG_NRM 1
+#define GX_TG_BINRM 2
+#define GX_TG_TANGENT 3
+#define GX_TG_TEX0 4
+#define GX_TG_TEX1 5
+#define GX_TG_TEX2 6
+#define GX_TG_TEX3 7
+#define GX_TG_TEX4 8
+#define GX_TG_TEX5 9
+#define GX_TG_TEX6 10
+#define GX_TG_TEX7 11
+#define GX_TG_TEXCOORD0 12
+#define GX_TG_COLOR0 19
+#define GX_TG_COLOR1 20
+
+#define GX_TEXCOORD0 0
+#define GX_TEXCOORD1 1
+#define GX_TEXCOORD2 2
+#define GX_TEXCOORD3 3
+#define GX_TEXCOORD4 4
+#define GX_TEXCOORD5 5
+#define GX_TEXCOORD6 6
+#define GX_TEXCOORD7 7
+#define GX_MAXCOORD 8
+#define GX_TEXCOORDNULL 0xff
+
+#define GX_TEXMAP0 0
+#define GX_TEXMAP1 1
+#define GX_TEXMAP2 2
+#define GX_TEXMAP3 3
+#define GX_TEXMAP4 4
+#define GX_TEXMAP5 5
+#define GX_TEXMAP6 6
+#define GX_TEXMAP7 7
+#define GX_MAX_TEXMAP 8
+#define GX_TEXMAP_NULL 0xff
+#define GX_TEXMAP_DISABLE 0x100
+
+/* Lighting channels */
+#define GX_COLOR0 0
+#define GX_COLOR1 1
+#define GX_ALPHA0 2
+#define GX_ALPHA1 3
+#define GX_COLOR0A0 4
+#define GX_COLOR1A1 5
+#define GX_COLORZERO 6
+#define GX_ALPHA_BUMP 7
+#define GX_ALPHA_BUMPN 8
+#define GX_COLORNULL 0xff
+
+#define GX_SRC_REG 0
+#define GX_SRC_VTX 1
+
+#define GX_DF_NONE 0
+#define GX_DF_SIGNED 1
+#define GX_DF_CLAMP 2
+
+#define GX_AF_SPEC 0
+#define GX_AF_SPOT 1
+#define GX_AF_NONE 2
+
+#define GX_LIGHT0 0x001
+#define GX_LIGHT1 0x002
+#define GX_LIGHT2 0x004
+#define GX_LIGHT3 0x008
+#define GX_LIGHT4 0x010
+#define GX_LIGHT5 0x020
+#define GX_LIGHT6 0x040
+#define GX_LIGHT7 0x080
+#define GX_MAXLIGHT 0x100
+#define GX_LIGHTNULL 0x000
+
+/* TEV */
+#define GX_TEVSTAGE0 0
+#define GX_TEVSTAGE1 1
+#define GX_TEVSTAGE2 2
+#define GX_TEVSTAGE3 3
+#define GX_TEVSTAGE4 4
+#define GX_TEVSTAGE5 5
+#define GX_TEVSTAGE6 6
+#define GX_TEVSTAGE7 7
+#define GX_TEVSTAGE8 8
+#define GX_TEVSTAGE9 9
+#define GX_TEVSTAGE10 10
+#define GX_TEVSTAGE11 11
+#define GX_TEVSTAGE12 12
+#define GX_TEVSTAGE13 13
+#define GX_TEVSTAGE14 14
+#define GX_TEVSTAGE15 15
+#define GX_MAX_TEVSTAGE 16
+
+#define GX_MODULATE 0
+#define GX_DECAL 1
+#define GX_BLEND 2
+#define GX_REPLACE 3
+#define GX_PASSCLR 4
+
+#define GX_CC_CPREV 0
+#define GX_CC_APREV 1
+#define GX_CC_C0 2
+#define GX_CC_A0 3
+#define GX_CC_C1 4
+#define GX_CC_A1 5
+#define GX_CC_C2 6
+#define GX_CC_A2 7
+#define GX_CC_TEXC 8
+#define GX_CC_TEXA 9
+#define GX_CC_RASC 10
+#define GX_CC_RASA 11
+#define GX_CC_ONE 12
+#define GX_CC_HALF 13
+#define GX_CC_KONST 14
+#define GX_CC_ZERO 15
+
+#define GX_CA_APREV 0
+#define GX_CA_A0 1
+#define GX_CA_A1 2
+#define GX_CA_A2 3
+#define GX_CA_TEXA 4
+#define GX_CA_RASA 5
+#define GX_CA_KONST 6
+#define GX_CA_ZERO 7
+
+#define GX_TEV_ADD 0
+#define GX_TEV_SUB 1
+#define GX_TEV_COMP_R8_GT 8
+#define GX_TEV_COMP_R8_EQ 9
+#define GX_TEV_COMP_GR16_GT 10
+#define GX_TEV_COMP_GR16_EQ 11
+#define GX_TEV_COMP_BGR24_GT 12
+#define GX_TEV_COMP_BGR24_EQ 13
+#define GX_TEV_COMP_RGB8_GT 14
+#define GX_TEV_COMP_RGB8_EQ 15
+#define GX_TEV_COMP_A8_GT GX_TEV_COMP_RGB8_GT
+#define GX_TEV_COMP_A8_EQ GX_TEV_COMP_RGB8_EQ
+
+#define GX_TB_ZERO 0
+#define GX_TB_ADDHALF 1
+#define GX_TB_SUBHALF 2
+
+#define GX_CS_SCALE_1 0
+#define GX_CS_SCALE_2 1
+#define GX_CS_SCALE_4 2
+#define GX_CS_DIVIDE_2 3
+
+#define GX_TEVPREV 0
+#define GX_TEVREG0 1
+#define GX_TEVREG1 2
+#define GX_TEVREG2 3
+#define GX_MAX_TEVREG 4
+
+#define GX_KCOLOR0 0
+#define GX_KCOLOR1 1
+#define GX_KCOLOR2 2
+#define GX_KCOLOR3 3
+#define GX_KCOLOR_MAX 4
+
+#define GX_TEV_KCSEL_1 0x00
+#define GX_TEV_KCSEL_7_8 0x01
+#define GX_TEV_KCSEL_3_4 0x02
+#define GX_TEV_KCSEL_5_8 0x03
+#define GX_TEV_KCSEL_1_2 0x04
+#define GX_TEV_KCSEL_3_8 0x05
+#define GX_TEV_KCSEL_1_4 0x06
+#define GX_TEV_KCSEL_1_8 0x07
+#define GX_TEV_KCSEL_K0 0x0C
+#define GX_TEV_KCSEL_K1 0x0D
+#define GX_TEV_KCSEL_K2 0x0E
+#define GX_TEV_KCSEL_K3 0x0F
+#define GX_TEV_KCSEL_K0_R 0x10
+#define GX_TEV_KCSEL_K1_R 0x11
+#define GX_TEV_KCSEL_K2_R 0x12
+#define GX_TEV_KCSEL_K3_R 0x13
+#define GX_TEV_KCSEL_K0_G 0x14
+#define GX_TEV_KCSEL_K1_G 0x15
+#define GX_TEV_KCSEL_K2_G 0x16
+#define GX_TEV_KCSEL_K3_G 0x17
+#define GX_TEV_KCSEL_K0_B 0x18
+#define GX_TEV_KCSEL_K1_B 0x19
+#define GX_TEV_KCSEL_K2_B 0x1A
+#define GX_TEV_KCSEL_K3_B 0x1B
+#define GX_TEV_KCSEL_K0_A 0x1C
+#define GX_TEV_KCSEL_K1_A 0x1D
+#define GX_TEV_KCSEL_K2_A 0x1E
+#define GX_TEV_KCSEL_K3_A 0x1F
+
+#define GX_TEV_KASEL_1 0x00
+#define GX_TEV_KASEL_7_8 0x01
+#define GX_TEV_KASEL_3_4 0x02
+#define GX_TEV_KASEL_5_8 0x03
+#define GX_TEV_KASEL_1_2 0x04
+#define GX_TEV_KASEL_3_8 0x05
+#define GX_TEV_KASEL_1_4 0x06
+#define GX_TEV_KASEL_1_8 0x07
+#define GX_TEV_KASEL_K0_R 0x10
+#define GX_TEV_KASEL_K1_R 0x11
+#define GX_TEV_KASEL_K2_R 0x12
+#define GX_TEV_KASEL_K3_R 0x13
+#define GX_TEV_KASEL_K0_G 0x14
+#define GX_TEV_KASEL_K1_G 0x15
+#define GX_TEV_KASEL_K2_G 0x16
+#define GX_TEV_KASEL_K3_G 0x17
+#define GX_TEV_KASEL_K0_B 0x18
+#define GX_TEV_KASEL_K1_B 0x19
+#define GX_TEV_KASEL_K2_B 0x1A
+#define GX_TEV_KASEL_K3_B 0x1B
+#define GX_TEV_KASEL_K0_A 0x1C
+#define GX_TEV_KASEL_K1_A 0x1D
+#define GX_TEV_KASEL_K2_A 0x1E
+#define GX_TEV_KASEL_K3_A 0x1F
+
+/* Texture formats */
+#define _GX_TF_ZTF 0x10
+#define _GX_TF_CTF 0x20
+
+#define GX_TF_I4 0x0
+#define GX_TF_I8 0x1
+#define GX_TF_IA4 0x2
+#define GX_TF_IA8 0x3
+#define GX_TF_RGB565 0x4
+#define GX_TF_RGB5A3 0x5
+#define GX_TF_RGBA8 0x6
+#define GX_TF_CI4 0x8
+#define GX_TF_CI8 0x9
+#define GX_TF_CI14 0xa
+#define GX_TF_CMPR 0xE
+#define GX_TF_A8 (0x7 | _GX_TF_CTF)
+#define GX_TF_Z8 (0x1 | _GX_TF_ZTF)
+#define GX_TF_Z16 (0x3 | _GX_TF_ZTF)
+#define GX_TF_Z24X8 (0x6 | _GX_TF_ZTF)
+
+#define GX_CTF_R4 (0x0 | _GX_TF_CTF)
+#define GX_CTF_RA4 (0x2 | _GX_TF_CTF)
+#define GX_CTF_RA8 (0x3 | _GX_TF_CTF)
+#define GX_CTF_YUVA8 (0x6 | _GX_TF_CTF)
+#define GX_CTF_A8 (0x7 | _GX_TF_CTF)
+#define GX_CTF_R8 (0x8 | _GX_TF_CTF)
+#define GX_CTF_G8 (0x9 | _GX_TF_CTF)
+#define GX_CTF_B8 (0xA | _GX_TF_CTF)
+#define GX_CTF_RG8 (0xB | _GX_TF_CTF)
+#define GX_CTF_GB8 (0xC | _GX_TF_CTF)
+
+#define GX_CLAMP 0
+#define GX_REPEAT 1
+#define GX_MIRROR 2
+
+#define GX_NEAR 0
+#define GX_LINEAR 1
+#define GX_NEAR_MIP_NEAR 2
+#define GX_LIN_MIP_NEAR 3
+#define GX_NEAR_MIP_LIN 4
+#define GX_LIN_MIP_LIN 5
+
+#define GX_ANISO_1 0
+#define GX_ANISO_2 1
+#define GX_ANISO_4 2
+
+/* Fog */
+#define GX_FOG_NONE 0
+#define GX_FOG_PERSP_LIN 2
+#define GX_FOG_PERSP_EXP 4
+#define GX_FOG_PERSP_EXP2 5
+#define GX_FOG_PERSP_REVEXP 6
+#define GX_FOG_PERSP_REVEXP2 7
+#define GX_FOG_ORTHO_LIN 10
+#define GX_FOG_ORTHO_EXP 12
+#define GX_FOG_ORTHO_EXP2 13
+#define GX_FOG_ORTHO_REVEXP 14
+#define GX_FOG_ORTHO_REVEXP2 15
+#define GX_FOG_LIN GX_FOG_PERSP_LIN
+#define GX_FOG_EXP GX_FOG_PERSP_EXP
+#define GX_FOG_EXP2 GX_FOG_PERSP_EXP2
+#define GX_FOG_REVEXP GX_FOG_PERSP_REVEXP
+#define GX_FOG_REVEXP2 GX_FOG_PERSP_REVEXP2
+
+/* Pixel engine */
+#define GX_PF_RGB8_Z24 0
+#define GX_PF_RGBA6_Z24 1
+#define GX_PF_RGB565_Z16 2
+#define GX_PF_Z24 3
+#define GX_PF_Y8 4
+#define GX_PF_U8 5
+#define GX_PF_V8 6
+#define GX_PF_YUV420 7
+
+#define GX_ZC_LINEAR 0
+#define GX_ZC_NEAR 1
+#define GX_ZC_MID 2
+#define GX_ZC_FAR 3
+
+#define GX_ZT_DISABLE 0
+#define GX_ZT_ADD 1
+#define GX_ZT_REPLACE 2
+
+#define GX_GM_1_0 0
+#define GX_GM_1_7 1
+#define GX_GM_2_2 2
+
+#define GX_TO_ZERO 0
+#define GX_TO_SIXTEENTH 1
+#define GX_TO_EIGHTH 2
+#define GX_TO_FOURTH 3
+#define GX_TO_HALF 4
+#define GX_TO_ONE 5
+
+typedef struct _gx_color {
+    u8 r;
+    u8 g;
+    u8 b;
+    u8 a;
+} GXColor;
+
+typedef struct _gx_colors10 {
+    s16 r;
+    s16 g;
+    s16 b;
+    s16 a;
+} GXColorS10;
+
+/* Unlike libogc's opaque struct, this one stores the texture parameters in
+ * plain fields, since pointers might not fit into 32 bits on the host. */
+typedef struct _gx_texobj {
+    void *data;
+    void *user_data;
+    u16 width;
+    u16 height;
+    u8 format;
+    u8 wrap_s;
+    u8 wrap_t;
+    u8 mipmap;
+    u8 min_filter;
+    u8 mag_filter;
+    u8 bias_clamp;
+    u8 edge_lod;
+    u8 max_aniso;
+    f32 min_lod;
+    f32 max_lod;
+    f32 lod_bias;
+} GXTexObj;
+
+typedef struct _gx_litobj {
+    f32 pos[3];
+    f32 dir[3];
+    f32 attn_a[3];
+    f32 attn_k[3];
+    GXColor color;
+} GXLightObj;
+
+typedef void (*GXDrawSyncCallback)(u16 token);
+typedef void (*GXDrawDoneCallback)(void);
+
+/* Vertex data. These are inline in libogc as well, since they just write
+ * into the FIFO. */
+static inline void GX_Begin(u8 primitive, u8 vtxfmt, u16 vtxcnt)
+{
+    GXHOST_COUNT(Begin);
+    _gxhost_write_u8(primitive | (vtxfmt & 0x7));
+    _gxhost_write_u16(vtxcnt);
+}
+
+static inline void GX_End(void)
+{
+    GXHOST_COUNT(End);
+}
+
+static inline void GX_Position3f32(f32 x, f32 y, f32 z)
+{
+    _gxhost_write_f32(x);
+    _gxhost_write_f32(y);
+    _gxhost_write_f32(z);
+}
+
+static inline void GX_Position2f32(f32 x, f32 y)
+{
+    _gxhost_write_f32(x);
+    _gxhost_write_f32(y);
+}
+
+static inline void GX_Position3s16(s16 x, s16 y, s16 z)
+{
+    _gxhost_write_u16(x);
+    _gxhost_write_u16(y);
+    _gxhost_write_u16(z);
+}
+
+static inline void GX_Position2u16(u16 x, u16 y)
+{
+    _gxhost_write_u16(x);
+    _gxhost_write_u16(y);
+}
+
+static inline void GX_Position2s16(s16 x, s16 y)
+{
+    _gxhost_write_u16(x);
+    _gxhost_write_u16(y);
+}
+
+static inline void GX_Position1x16(u16 index)
+{
+    _gxhost_write_u16(index);
+}
+
+static inline void GX_Position1x8(u8 index)
+{
+    _gxhost_write_u8(index);
+}
+
+static inline void GX_Normal3f32(f32 nx, f32 ny, f32 nz)
+{
+    _gxhost_write_f32(nx);
+    _gxhost_write_f32(ny);
+    _gxhost_write_f32(nz);
+}
+
+static inline void GX_Normal3s16(s16 nx, s16 ny, s16 nz)
+{
+    _gxhost_write_u16(nx);
+    _gxhost_write_u16(ny);
+    _gxhost_write_u16(nz);
+}
+
+static inline void GX_Normal1x16(u16 index)
+{
+    _gxhost_write_u16(index);
+}
+
+static inline void GX_Normal1x8(u8 index)
+{
+    _gxhost_write_u8(index);
+}
+
+static inline void GX_Color4u8(u8 r, u8 g, u8 b, u8 a)
+{
+    _gxhost_write_u8(r);
+    _gxhost_write_u8(g);
+    _gxhost_write_u8(b);
+    _gxhost_write_u8(a);
+}
+
+static inline void GX_Color3u8(u8 r, u8 g, u8 b)
+{
+    _gxhost_write_u8(r);
+    _gxhost_write_u8(g);
+    _gxhost_write_u8(b);
+}
+
+static inline void GX_Color1u32(u32 clr)
+{
+    _gxhost_write_u32(clr);
+}
+
+static inline void GX_Color1x16(u16 index)
+{
+    _gxhost_write_u16(index);
+}
+
+static inline void GX_Color1x8(u8 index)
+{
+    _gxhost_write_u8(index);
+}
+
+static inline void GX_TexCoord2f32(f32 s, f32 t)
+{
+    _gxhost_write_f32(s);
+    _gxhost_write_f32(t);
+}
+
+static inline void GX_TexCoord1f32(f32 s)
+{
+    _gxhost_write_f32(s);
+}
+
+static inline void GX_TexCoord2s16(s16 s, s16 t)
+{
+    _gxhost_write_u16(s);
+    _gxhost_write_u16(t);
+}
+
+static inline void GX_TexCoord2u16(u16 s, u16 t)
+{
+    _gxhost_write_u16(s);
+    _gxhost_write_u16(t);
+}
+
+static inline void GX_TexCoord2u8(u8 s, u8 t)
+{
+    _gxhost_write_u8(s);
+    _gxhost_write_u8(t);
+}
+
+static inline void GX_TexCoord1x16(u16 index)
+{
+    _gxhost_write_u16(index);
+}
+
+static inline void GX_TexCoord1x8(u8 index)
+{
+    _gxhost_write_u8(index);
+}
+
+static inline void GX_MatrixIndex1x8(u8 index)
+{
+    _gxhost_write_u8(index);
+}
+
+/* Display lists */
+void GX_BeginDispList(void *list, u32 size);
+u32 GX_EndDispList(void);
+void GX_CallDispList(const void *list, u32 nbytes);
+
+/* Vertex descriptors */
+void GX_SetArray(u32 attr, const void *ptr, u8 stride);
+void GX_SetVtxDesc(u8 attr, u8 type);
+void GX_SetVtxAttrFmt(u8 vtxfmt, u32 vtxattr, u32 comptype, u32 compsize,
+                      u32 frac);
+void GX_ClearVtxDesc(void);
+void GX_InvVtxCache(void);
+
+/* Transform */
+void GX_SetCurrentMtx(u32 mtx);
+void GX_LoadPosMtxImm(const Mtx mt, u32 pnidx);
+void GX_LoadNrmMtxImm(const Mtx mt, u32 pnidx);
+void GX_LoadTexMtxImm(const Mtx mt, u32 texidx, u8 type);
+void GX_LoadProjectionMtx(const Mtx44 mt, u8 type);
+void GX_SetViewport(f32 xOrig, f32 yOrig, f32 wd, f32 ht,
+                    f32 nearZ, f32 farZ);
+void GX_SetScissor(u32 xOrigin, u32 yOrigin, u32 wd, u32 ht);
+void GX_SetCullMode(u8 mode);
+
+/* Pixel engine */
+void GX_SetZMode(u8 enable, u8 func, u8 update_enable);
+void GX_SetZCompLoc(u8 before_tex);
+void GX_SetZTexture(u8 op, u8 fmt, u32 bias);
+void GX_SetAlphaCompare(u8 comp0, u8 ref0, u8 aop, u8 comp1, u8 ref1);
+void GX_SetAlphaUpdate(u8 enable);
+void GX_SetColorUpdate(u8 enable);
+void GX_SetBlendMode(u8 type, u8 src_fact, u8 dst_fact, u8 op);
+void GX_SetFog(u8 type, f32 startz, f32 endz, f32 nearz, f32 farz,
+               GXColor col);
+void GX_SetPixelFmt(u8 pix_fmt, u8 z_fmt);
+void GX_SetDispCopyGamma(u8 gamma);
+void GX_SetLineWidth(u8 width, u8 fmt);
+void GX_SetPointSize(u8 width, u8 fmt);
+void GX_EnableTexOffsets(u8 coord, u8 line_enable, u8 point_enable);
+
+/* Lighting channels and TEV */
+void GX_SetNumChans(u8 num);
+void GX_SetNumTexGens(u32 nr);
+void GX_SetNumTevStages(u8 num);
+void GX_SetChanCtrl(s32 channel, u8 enable, u8 ambsrc, u8 matsrc,
+                    u8 litmask, u8 diff_fn, u8 attn_fn);
+void GX_SetChanAmbColor(s32 channel, GXColor color);
+void GX_SetChanMatColor(s32 channel, GXColor color);
+void GX_SetTevOp(u8 tevstage, u8 mode);
+void GX_SetTevOrder(u8 tevstage, u8 texcoord, u32 texmap, u8 color);
+void GX_SetTevColorIn(u8 tevstage, u8 a, u8 b, u8 c, u8 d);
+void GX_SetTevAlphaIn(u8 tevstage, u8 a, u8 b, u8 c, u8 d);
+void GX_SetTevColorOp(u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale,
+                      u8 clamp, u8 tevregid);
+void GX_SetTevAlphaOp(u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale,
+                      u8 clamp, u8 tevregid);
+void GX_SetTevColor(u8 tev_regid, GXColor color);
+void GX_SetTevKColor(u8 sel, GXColor col);
+void GX_SetTevKColorSel(u8 tevstage, u8 sel);
+void GX_SetTevKAlphaSel(u8 tevstage, u8 sel);
+void GX_SetTexCoordGen2(u16 texcoord, u32 tgen_typ, u32 tgen_src,
+                        u32 mtxsrc, u32 normalize, u32 postmtx);
+#define GX_SetTexCoordGen(texcoord, tgen_typ, tgen_src, mtxsrc) \
+    GX_SetTexCoordGen2((texcoord), (tgen_typ), (tgen_src), (mtxsrc), \
+                       GX_FALSE, GX_DTTIDENTITY)
+
+/* Lights */
+void GX_InitLightPos(GXLightObj *lit_obj, f32 x, f32 y, f32 z);
+void GX_InitLightDir(GXLightObj *lit_obj, f32 nx, f32 ny, f32 nz);
+void GX_InitLightColor(GXLightObj *lit_obj, GXColor col);
+void GX_InitLightAttn(GXLightObj *lit_obj, f32 a0, f32 a1, f32 a2,
+                      f32 k0, f32 k1, f32 k2);
+void GX_InitSpecularDir(GXLightObj *lit_obj, f32 nx, f32 ny, f32 nz);
+void GX_LoadLightObj(GXLightObj *lit_obj, u8 lit_id);
+#define GX_InitLightPosv(lo, vec) \
+    GX_InitLightPos((lo), ((f32 *)(vec))[0], ((f32 *)(vec))[1], \
+                    ((f32 *)(vec))[2])
+#define GX_InitLightDirv(lo, vec) \
+    GX_InitLightDir((lo), ((f32 *)(vec))[0], ((f32 *)(vec))[1], \
+                    ((f32 *)(vec))[2])
+#define GX_InitSpecularDirv(lo, vec) \
+    GX_InitSpecularDir((lo), ((f32 *)(vec))[0], ((f32 *)(vec))[1], \
+                       ((f32 *)(vec))[2])
+#define GX_InitLightShininess(lobj, shininess) \
+    GX_InitLightAttn(lobj, 0.0F, 0.0F, 1.0F, (shininess) / 2.0F, 0.0F, \
+                     1.0F - (shininess) / 2.0F)
+
+/* Textures */
+u32 GX_GetTexBufferSize(u16 wd, u16 ht, u32 fmt, u8 mipmap, u8 maxlod);
+void GX_InitTexObj(GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt,
+                   u8 wrap_s, u8 wrap_t, u8 mipmap);
+void GX_InitTexObjLOD(GXTexObj *obj, u8 minfilt, u8 magfilt, f32 minlod,
+                      f32 maxlod, f32 lodbias, u8 biasclamp, u8 edgelod,
+                      u8 maxaniso);
+void GX_InitTexObjFilterMode(GXTexObj *obj, u8 minfilt, u8 magfilt);
+void GX_InitTexObjWrapMode(GXTexObj *obj, u8 wrap_s, u8 wrap_t);
+void GX_InitTexObjUserData(GXTexObj *obj, void *userdata);
+void GX_GetTexObjAll(const GXTexObj *obj, void **image_ptr, u16 *width,
+                     u16 *height, u8 *format, u8 *wrap_s, u8 *wrap_t,
+                     u8 *mipmap);
+void *GX_GetTexObjData(const GXTexObj *obj);
+u16 GX_GetTexObjWidth(const GXTexObj *obj);
+u16 GX_GetTexObjHeight(const GXTexObj *obj);
+u32 GX_GetTexObjFmt(const GXTexObj *obj);
+u8 GX_GetTexObjWrapS(const GXTexObj *obj);
+u8 GX_GetTexObjWrapT(const GXTexObj *obj);
+void GX_GetTexObjFilterMode(const GXTexObj *obj, u8 *minfilt, u8 *magfilt);
+void GX_GetTexObjLOD(const GXTexObj *obj, f32 *minlod, f32 *maxlod);
+void *GX_GetTexObjUserData(const GXTexObj *obj);
+void GX_LoadTexObj(const GXTexObj *obj, u8 mapid);
+void GX_InvalidateTexAll(void);
+
+/* EFB copies */
+void GX_SetTexCopySrc(u16 left, u16 top, u16 wd, u16 ht);
+void GX_SetTexCopyDst(u16 wd, u16 ht, u32 fmt, u8 mipmap);
+void GX_CopyTex(void *dest, u8 clear);
+void GX_SetCopyFilter(u8 aa, u8 sample_pattern[12][2], u8 vf,
+                      u8 vfilter[7]);
+void GX_PixModeSync(void);
+void GX_ClearBoundingBox(void);
+void GX_ReadBoundingBox(u16 *top, u16 *bottom, u16 *left, u16 *right);
+
+/* Synchronization */
+void GX_SetDrawSync(u16 token);
+u16 GX_GetDrawSync(void);
+GXDrawSyncCallback GX_SetDrawSyncCallback(GXDrawSyncCallback cb);
+void GX_SetDrawDone(void);
+void GX_WaitDrawDone(void);
+void GX_DrawDone(void);
+
+#ifdef __cplusplus
+} // extern C
+
+/* In libogc, wgPipe points to the memory-mapped write-gather pipe; here we
+ * emulate it with an object whose members append to the recorded FIFO when
+ * assigned to. */
+struct _GXHostPipe {
+    struct {
+        void operator=(u8 value) { _gxhost_write_u8(value); }
+    } U8, S8;
+    struct {
+        void operator=(u16 value) { _gxhost_write_u16(value); }
+    } U16, S16;
+    struct {
+        void operator=(u32 value) { _gxhost_write_u32(value); }
+    } U32, S32;
+    struct {
+        void operator=(f32 value) { _gxhost_write_f32(value); }
+    } F32;
+};
+
+extern _GXHostPipe _gxhost_pipe;
+#define wgPipe (&_gxhost_pipe)
+#endif
+
+#endif /* GXHOST_GX_H */
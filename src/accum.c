@@ -167,6 +167,8 @@ void glAccum(GLenum op, GLfloat value)
     GXTexObj *texture = NULL;
     bool must_draw = false;
 
+    _ogx_flush_draw_batch();
+
     _ogx_efb_buffer_prepare(&s_accum_buffer, GX_TF_RGBA8);
     if (op == GL_ACCUM || op == GL_LOAD) {
         scene_buffer = save_scene_into_texture();
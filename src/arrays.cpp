@@ -36,6 +36,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "vbo.h"
 
 #include <cassert>
+#include <climits>
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <limits>
@@ -60,6 +62,14 @@ static char s_num_tex_coords = 0;
 static bool s_has_normals = false;
 static uint8_t s_num_colors = 0;
 static OgxDrawFlags s_draw_flags = OGX_DRAW_FLAG_NONE;
+static uint8_t s_matrix_index = GX_PNMTX0;
+static struct {
+    const uint8_t *indices; /* NULL if s_matrix_index is used */
+    int stride;
+    bool is_short;
+    int count;
+    const uint8_t *pnmtx;
+} s_matrix_palette;
 
 static inline int count_attributes() {
     return 1 /* pos */ + s_has_normals + s_num_colors + s_num_tex_arrays;
@@ -70,6 +80,7 @@ struct GxVertexFormat {
     char num_components;
     uint8_t type;
     uint8_t size;
+    uint8_t frac; /* fractional bits of fixed point data */
 
     int stride() const {
         int component_size;
@@ -217,23 +228,112 @@ static void to_tex2f(const T *components, int num_components, Tex2f tex) {
     }
 }
 
+/* Describes how a reader feeds its attribute into the GX pipe, for the benefit
+ * of the fused emitters below. */
+enum VertexStreamKind {
+    /* The reader needs to run its own process_element() */
+    STREAM_CUSTOM = 0,
+    /* The element data is copied verbatim from data + index * stride */
+    STREAM_DIRECT,
+    /* The element is sent as a 16-bit index into a GX array */
+    STREAM_INDEX16,
+};
+
+struct VertexStream {
+    GxVertexFormat format;
+    const char *data;
+    int stride;
+};
+
+/* Vertex attribute formats are cached in the GX_VTXFMT* slots made available
+ * by ogx_gpu_resources: the readers describe their attributes into
+ * s_vertex_layout, and if the same layout is already programmed in one of the
+ * slots we just switch to it, without rewriting the attribute format
+ * registers. Otherwise, the least recently used slot is reprogrammed. */
+#define NUM_LAYOUT_ATTRIBUTES (GX_VA_TEX7 - GX_VA_POS + 1)
+
+struct VertexLayout {
+    /* For each attribute, 0 if unused, else
+     * 0x8000 | (frac << 8) | (type << 4) | size */
+    uint16_t attributes[NUM_LAYOUT_ATTRIBUTES];
+
+    void clear() { memset(attributes, 0, sizeof(attributes)); }
+    void add(const GxVertexFormat &format) {
+        assert(format.attribute >= GX_VA_POS &&
+               format.attribute <= GX_VA_TEX7);
+        attributes[format.attribute - GX_VA_POS] =
+            0x8000 | (format.frac << 8) | (format.type << 4) | format.size;
+    }
+    bool operator==(const VertexLayout &other) const {
+        return memcmp(attributes, other.attributes, sizeof(attributes)) == 0;
+    }
+
+    void write_to_slot(uint8_t vtxfmt) const {
+        for (int i = 0; i < NUM_LAYOUT_ATTRIBUTES; i++) {
+            uint16_t a = attributes[i];
+            if (!a) continue;
+            GX_SetVtxAttrFmt(vtxfmt, GX_VA_POS + i,
+                             (a >> 4) & 0x7, a & 0xf, (a >> 8) & 0x1f);
+        }
+    }
+};
+
+static VertexLayout s_vertex_layout;
+static struct {
+    VertexLayout layout;
+    /* 0 if the slot does not hold a valid layout */
+    uint32_t last_used;
+} s_vtxfmt_cache[GX_MAXVTXFMT];
+static uint32_t s_vtxfmt_clock = 0;
+static uint8_t s_vtxfmt = GX_VTXFMT0;
+
+static uint8_t vtxfmt_for_layout(const VertexLayout &layout)
+{
+    int first = ogx_gpu_resources->vtxfmt_first;
+    int end = ogx_gpu_resources->vtxfmt_end;
+    if (first >= end) {
+        /* No slots available for caching: just reuse the first one */
+        s_vtxfmt_cache[GX_VTXFMT0].last_used = 0;
+        layout.write_to_slot(GX_VTXFMT0);
+        return GX_VTXFMT0;
+    }
+
+    s_vtxfmt_clock++;
+    int victim = first;
+    for (int i = first; i < end; i++) {
+        if (s_vtxfmt_cache[i].last_used != 0 &&
+            s_vtxfmt_cache[i].layout == layout) {
+            s_vtxfmt_cache[i].last_used = s_vtxfmt_clock;
+            return i;
+        }
+        if (s_vtxfmt_cache[i].last_used < s_vtxfmt_cache[victim].last_used)
+            victim = i;
+    }
+
+    layout.write_to_slot(victim);
+    s_vtxfmt_cache[victim].layout = layout;
+    s_vtxfmt_cache[victim].last_used = s_vtxfmt_clock;
+    return victim;
+}
+
 struct AbstractVertexReader {
     AbstractVertexReader(GxVertexFormat format): format(format) {}
 
     virtual void setup_draw() {
         GX_SetVtxDesc(format.attribute, GX_DIRECT);
-        GX_SetVtxAttrFmt(GX_VTXFMT0, format.attribute,
-                         format.type, format.size, 0);
+        s_vertex_layout.add(format);
     }
 
     virtual void draw_done() {};
 
     virtual void get_format(uint8_t *attribute, uint8_t *inputmode,
-                            uint8_t *type, uint8_t *size) const {
+                            uint8_t *type, uint8_t *size,
+                            uint8_t *frac) const {
         *attribute = format.attribute;
         *inputmode = GX_DIRECT;
         *type = format.type;
         *size = format.size;
+        *frac = format.frac;
     }
 
     virtual uint8_t get_tex_coord_source() const {
@@ -259,6 +359,10 @@ struct AbstractVertexReader {
         }
     }
 
+    virtual VertexStreamKind get_stream(VertexStream *stream) const {
+        return STREAM_CUSTOM;
+    }
+
     virtual void process_element(int index) = 0;
 
     virtual void read_color(int index, GXColor *color) const = 0;
@@ -292,6 +396,12 @@ struct ConstantVertexReader: public AbstractVertexReader {
         }
     }
 
+    /* A constant value is like an array with a stride of zero */
+    VertexStreamKind get_stream(VertexStream *stream) const override {
+        *stream = { format, reinterpret_cast<const char *>(values), 0 };
+        return STREAM_DIRECT;
+    }
+
     void read_pos3f(int index, Pos3f pos) const override {
         to_pos3f(values, format.num_components, pos);
     }
@@ -345,7 +455,8 @@ struct TexCoordProxyVertexReader: public AbstractVertexReader {
     void process_element(int index) override {}
     void setup_draw() override {}
     void get_format(uint8_t *attribute, uint8_t *inputmode,
-                    uint8_t *type, uint8_t *size) const override {
+                    uint8_t *type, uint8_t *size,
+                    uint8_t *frac) const override {
         *inputmode = GX_NONE;
     }
 
@@ -401,8 +512,7 @@ struct DirectVboReader: public VertexReaderBase {
     void setup_draw() override {
         GX_SetArray(format.attribute, const_cast<char*>(data), stride);
         GX_SetVtxDesc(format.attribute, GX_INDEX16);
-        GX_SetVtxAttrFmt(GX_VTXFMT0, format.attribute,
-                         format.type, format.size, 0);
+        s_vertex_layout.add(format);
     }
 
     void draw_done() override {
@@ -413,11 +523,17 @@ struct DirectVboReader: public VertexReaderBase {
     }
 
     void get_format(uint8_t *attribute, uint8_t *inputmode,
-                    uint8_t *type, uint8_t *size) const override {
-        VertexReaderBase::get_format(attribute, inputmode, type, size);
+                    uint8_t *type, uint8_t *size,
+                    uint8_t *frac) const override {
+        VertexReaderBase::get_format(attribute, inputmode, type, size, frac);
         *inputmode = GX_INDEX16;
     }
 
+    VertexStreamKind get_stream(VertexStream *stream) const override {
+        *stream = { format, data, stride };
+        return STREAM_INDEX16;
+    }
+
     void process_element(int index) {
         GX_Position1x16(index);
     }
@@ -445,6 +561,9 @@ struct DirectVboReader: public VertexReaderBase {
         case GX_S8: read_floats<int8_t>(index, out); break;
         case GX_U8: read_floats<uint8_t>(index, out); break;
         }
+        if (format.frac) {
+            for (int i = 0; i < 3; i++) out[i] = ldexpf(out[i], -format.frac);
+        }
     }
 
     void read_pos3f(int index, Pos3f pos) const override {
@@ -488,14 +607,22 @@ struct GenericVertexReader: public VertexReaderBase {
         }
     }
 
-    /* The following methods are only kept because of glArrayElement() */
+    /* The following methods are used by glArrayElement() and to convert the
+     * VBO data into a GX format */
     void read_color(int index, GXColor *color) const override {
         const T *ptr = elemAt(index);
         color->r = read_color_component(ptr++);
-        color->g = read_color_component(ptr++);
-        color->b = read_color_component(ptr++);
-        color->a = format.num_components == 4 ?
-            read_color_component(ptr++) : 255;
+        if (format.num_components >= 3) {
+            color->g = read_color_component(ptr++);
+            color->b = read_color_component(ptr++);
+            color->a = format.num_components == 4 ?
+                read_color_component(ptr++) : 255;
+        } else {
+            /* Same as ColorVertexReader */
+            color->g = color->b = color->r;
+            color->a = format.num_components == 2 ?
+                read_color_component(ptr++) : color->r;
+        }
     }
 
     void read_pos3f(int index, Pos3f pos) const override {
@@ -538,6 +665,13 @@ struct SameTypeVertexReader: public GenericVertexReader<T> {
     using GenericVertexReader<T>::GenericVertexReader;
     using GenericVertexReader<T>::elemAt;
     using GenericVertexReader<T>::format;
+    using GenericVertexReader<T>::data;
+    using GenericVertexReader<T>::stride;
+
+    VertexStreamKind get_stream(VertexStream *stream) const override {
+        *stream = { format, data, stride };
+        return STREAM_DIRECT;
+    }
 
     void process_element(int index) override {
         const T *ptr = elemAt(index);
@@ -613,25 +747,631 @@ struct CoordVertexReader: public GenericVertexReader<T> {
     }
 };
 
+/* Converts the VBO data described by key into a format that GX can read from
+ * an array (see shadow_format()). */
+template <typename T>
+static void convert_to_shadow(void *dst, const void *src, int count,
+                              const OgxVboShadowKey *key,
+                              OgxVboShadowFormat *)
+{
+    /* The output format is always the one given by shadow_format() */
+    if (!dst) return;
+
+    GxVertexFormat format = { key->attribute, char(key->size), 0, 0 };
+    CoordVertexReader<T> reader(format, src, key->stride);
+    float *out_f = static_cast<float *>(dst);
+    uint8_t *out_u8 = static_cast<uint8_t *>(dst);
+    for (int i = 0; i < count; i++) {
+        switch (key->attribute) {
+        case GX_VA_POS:
+            Pos3f pos;
+            reader.read_pos3f(i, pos);
+            *out_f++ = pos[0];
+            *out_f++ = pos[1];
+            if (key->size != 2) *out_f++ = pos[2];
+            break;
+        case GX_VA_NRM:
+            reader.read_norm3f(i, out_f);
+            out_f += 3;
+            break;
+        case GX_VA_CLR0:
+        case GX_VA_CLR1:
+            GXColor c;
+            reader.read_color(i, &c);
+            *out_u8++ = c.r;
+            *out_u8++ = c.g;
+            *out_u8++ = c.b;
+            if (key->size != 3) *out_u8++ = c.a;
+            break;
+        default: /* texture coordinates */
+            Tex2f tex;
+            reader.read_tex2f(i, tex);
+            *out_f++ = tex[0];
+            if (key->size != 1) *out_f++ = tex[1];
+        }
+    }
+}
+
+static OgxVboConvertFunc shadow_converter(GLenum type)
+{
+    switch (type) {
+    case GL_BYTE: return convert_to_shadow<int8_t>;
+    case GL_UNSIGNED_BYTE: return convert_to_shadow<uint8_t>;
+    case GL_SHORT: return convert_to_shadow<int16_t>;
+    case GL_UNSIGNED_SHORT: return convert_to_shadow<uint16_t>;
+    case GL_INT: return convert_to_shadow<int32_t>;
+    case GL_UNSIGNED_INT: return convert_to_shadow<uint32_t>;
+    case GL_FLOAT: return convert_to_shadow<float>;
+    case GL_DOUBLE: return convert_to_shadow<double>;
+    }
+    return NULL;
+}
+
+/* The GX format of the data produced by convert_to_shadow() */
+static GxVertexFormat shadow_format(GxVertexFormat format)
+{
+    switch (format.attribute) {
+    case GX_VA_CLR0:
+    case GX_VA_CLR1:
+        format.num_components = format.size == GX_RGB8 ? 3 : 4;
+        break;
+    case GX_VA_POS:
+        format.num_components = format.type == GX_POS_XY ? 2 : 3;
+        format.size = GX_F32;
+        break;
+    default: /* Normals and texture coordinates */
+        format.size = GX_F32;
+    }
+    return format;
+}
+
+/* Quantization of float data into the GX fixed point formats: the tightest
+ * format whose rounding error is within key->max_error is chosen. GX applies
+ * the frac shift to positions and texture coordinates only; normals always
+ * have 6 (S8) or 14 (S16) fractional bits. */
+struct QuantizedFormat {
+    uint8_t size;
+    int max_value;
+    int normal_frac;
+};
+
+static const QuantizedFormat s_quantized_formats[] = {
+    { GX_U8, 0xff, -1 },
+    { GX_S8, 0x7f, 6 },
+    { GX_U16, 0xffff, -1 },
+    { GX_S16, 0x7fff, 14 },
+};
+
+static void quantize_to_shadow(void *dst, const void *src, int count,
+                               const OgxVboShadowKey *key,
+                               OgxVboShadowFormat *format)
+{
+    int n = key->size;
+    if (!dst) {
+        float max_abs = 0.0f, min_value = 0.0f;
+        for (int i = 0; i < count; i++) {
+            const float *elem = reinterpret_cast<const float *>(
+                static_cast<const char *>(src) + i * key->stride);
+            for (int c = 0; c < n; c++) {
+                if (fabsf(elem[c]) > max_abs) max_abs = fabsf(elem[c]);
+                if (elem[c] < min_value) min_value = elem[c];
+            }
+        }
+
+        bool is_normal = key->attribute == GX_VA_NRM;
+        for (const QuantizedFormat &q: s_quantized_formats) {
+            bool is_signed = q.size == GX_S8 || q.size == GX_S16;
+            if (is_normal ? q.normal_frac < 0 :
+                (!is_signed && min_value < 0.0f)) continue;
+
+            int frac;
+            if (is_normal) {
+                frac = q.normal_frac;
+                if (max_abs * (1 << frac) > q.max_value) continue;
+            } else {
+                /* Use as many fractional bits as the range allows */
+                for (frac = 31; frac >= 0; frac--) {
+                    if (ldexpf(max_abs, frac) <= q.max_value) break;
+                }
+                if (frac < 0) continue;
+            }
+
+            if (ldexpf(0.5f, -frac) <= key->max_error) {
+                format->size = q.size;
+                format->frac = frac;
+                format->stride = n * (q.max_value > 0xff ? 2 : 1);
+                return;
+            }
+        }
+        /* No fixed point format is precise enough */
+        format->size = GX_F32;
+        format->frac = 0;
+        format->stride = n * sizeof(float);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const float *elem = reinterpret_cast<const float *>(
+            static_cast<const char *>(src) + i * key->stride);
+        for (int c = 0; c < n; c++) {
+            float value = ldexpf(elem[c], format->frac);
+            switch (format->size) {
+            case GX_U8: *static_cast<uint8_t *>(dst) = lrintf(value); break;
+            case GX_S8: *static_cast<int8_t *>(dst) = lrintf(value); break;
+            case GX_U16: *static_cast<uint16_t *>(dst) = lrintf(value); break;
+            case GX_S16: *static_cast<int16_t *>(dst) = lrintf(value); break;
+            default: *static_cast<float *>(dst) = elem[c];
+            }
+            dst = static_cast<char *>(dst) + format->stride / n;
+        }
+    }
+}
+
+/* Whether the data of the array can be quantized to fixed point */
+static bool can_quantize(const OgxVertexAttribArray *array, uint8_t attribute)
+{
+    if (array->type != GL_FLOAT) return false;
+    switch (attribute) {
+    case GX_VA_POS: return array->size == 2 || array->size == 3;
+    case GX_VA_NRM: return array->size == 3;
+    case GX_VA_CLR0:
+    case GX_VA_CLR1: return false;
+    default: return array->size <= 2;
+    }
+}
+
+/* Fused emitters: when all the active readers are just copying their input
+ * data into the GX pipe, we can avoid the per-attribute virtual dispatch of
+ * _ogx_arrays_process_element() and instead use an emitter which has been
+ * specialised at compile time for the exact vertex format, and which writes
+ * all the attributes of a vertex in one go. */
+enum FusedStreamSlot {
+    SLOT_POS = 0,
+    SLOT_NRM,
+    SLOT_CLR,
+    SLOT_TEX,
+    NUM_SLOTS,
+};
+
+template <typename T>
+static inline const T *stream_elem(const VertexStream &stream, int index)
+{
+    return reinterpret_cast<const T*>(stream.data + stream.stride * index);
+}
+
+/* The template parameters are the number of components of each attribute (0
+ * if the attribute is not present). Positions, normals and texture
+ * coordinates are floats, colors are unsigned bytes. */
+template <int PosN, int NrmN, int ClrN, int TexN>
+struct DirectVertexEmitter {
+    static inline void emit(const VertexStream *streams, int index) {
+        const float *pos = stream_elem<float>(streams[SLOT_POS], index);
+        if constexpr (PosN == 3) {
+            GX_Position3f32(pos[0], pos[1], pos[2]);
+        } else {
+            GX_Position2f32(pos[0], pos[1]);
+        }
+
+        if constexpr (NrmN == 3) {
+            const float *nrm = stream_elem<float>(streams[SLOT_NRM], index);
+            GX_Normal3f32(nrm[0], nrm[1], nrm[2]);
+        }
+
+        if constexpr (ClrN == 4) {
+            const uint8_t *c = stream_elem<uint8_t>(streams[SLOT_CLR], index);
+            GX_Color4u8(c[0], c[1], c[2], c[3]);
+        } else if constexpr (ClrN == 3) {
+            const uint8_t *c = stream_elem<uint8_t>(streams[SLOT_CLR], index);
+            GX_Color3u8(c[0], c[1], c[2]);
+        }
+
+        if constexpr (TexN == 2) {
+            const float *tex = stream_elem<float>(streams[SLOT_TEX], index);
+            GX_TexCoord2f32(tex[0], tex[1]);
+        }
+    }
+};
+
+/* Subtracted from the indices sent by the IndexedVertexEmitter, when the GX
+ * arrays have been set to start at the lowest index used by the draw */
+static int s_index_base = 0;
+
+/* All attributes are read by the GPU from arrays, and are sent as indices */
+template <int NumAttributes, typename IndexType>
+struct IndexedVertexEmitter {
+    static inline void emit(const VertexStream *streams, int index) {
+        index -= s_index_base;
+        for (int i = 0; i < NumAttributes; i++) {
+            if constexpr (sizeof(IndexType) == 1) {
+                GX_Position1x8(index);
+            } else {
+                GX_Position1x16(index);
+            }
+        }
+    }
+};
+
+typedef void (*FusedRangeFunc)(const VertexStream *streams,
+                               int first, int count, bool loop);
+typedef void (*FusedElementsFunc)(const VertexStream *streams,
+                                  const void *indices, int count, bool loop);
+
+struct FusedEmitter {
+    FusedRangeFunc emit_range;
+    /* Indexed by index type: GL_UNSIGNED_BYTE, _SHORT and _INT */
+    FusedElementsFunc emit_elements[3];
+};
+
+template <typename Emitter>
+static void fused_emit_range(const VertexStream *streams,
+                             int first, int count, bool loop)
+{
+    for (int i = first; i < first + count; i++) {
+        Emitter::emit(streams, i);
+    }
+    if (loop) Emitter::emit(streams, first);
+}
+
+template <typename Emitter, typename IndexType>
+static void fused_emit_elements(const VertexStream *streams,
+                                const void *indices, int count, bool loop)
+{
+    const IndexType *idx = static_cast<const IndexType *>(indices);
+    for (int i = 0; i < count; i++) {
+        Emitter::emit(streams, idx[i]);
+    }
+    if (loop) Emitter::emit(streams, idx[0]);
+}
+
+template <typename Emitter>
+static constexpr FusedEmitter fused_emitter()
+{
+    return {
+        fused_emit_range<Emitter>,
+        {
+            fused_emit_elements<Emitter, uint8_t>,
+            fused_emit_elements<Emitter, uint16_t>,
+            fused_emit_elements<Emitter, uint32_t>,
+        },
+    };
+}
+
+#define DIRECT(p, n, c, t) fused_emitter<DirectVertexEmitter<p, n, c, t>>()
+/* Indexed by: position (XY, XYZ), normal (none, XYZ), color (none, RGB,
+ * RGBA), texture coordinate (none, ST) */
+static const FusedEmitter s_direct_emitters[2][2][3][2] = {
+    {
+        {
+            { DIRECT(2, 0, 0, 0), DIRECT(2, 0, 0, 2) },
+            { DIRECT(2, 0, 3, 0), DIRECT(2, 0, 3, 2) },
+            { DIRECT(2, 0, 4, 0), DIRECT(2, 0, 4, 2) },
+        },
+        {
+            { DIRECT(2, 3, 0, 0), DIRECT(2, 3, 0, 2) },
+            { DIRECT(2, 3, 3, 0), DIRECT(2, 3, 3, 2) },
+            { DIRECT(2, 3, 4, 0), DIRECT(2, 3, 4, 2) },
+        },
+    },
+    {
+        {
+            { DIRECT(3, 0, 0, 0), DIRECT(3, 0, 0, 2) },
+            { DIRECT(3, 0, 3, 0), DIRECT(3, 0, 3, 2) },
+            { DIRECT(3, 0, 4, 0), DIRECT(3, 0, 4, 2) },
+        },
+        {
+            { DIRECT(3, 3, 0, 0), DIRECT(3, 3, 0, 2) },
+            { DIRECT(3, 3, 3, 0), DIRECT(3, 3, 3, 2) },
+            { DIRECT(3, 3, 4, 0), DIRECT(3, 3, 4, 2) },
+        },
+    },
+};
+#undef DIRECT
+
+#define INDEXED(n, t) fused_emitter<IndexedVertexEmitter<n, t>>()
+/* Indexed by: index size (16, 8 bits), number of attributes */
+static const FusedEmitter s_indexed_emitters[2][NUM_SLOTS] = {
+    {
+        INDEXED(1, uint16_t), INDEXED(2, uint16_t),
+        INDEXED(3, uint16_t), INDEXED(4, uint16_t),
+    },
+    {
+        INDEXED(1, uint8_t), INDEXED(2, uint8_t),
+        INDEXED(3, uint8_t), INDEXED(4, uint8_t),
+    },
+};
+#undef INDEXED
+
+/* NULL if the generic readers must be used */
+static const FusedEmitter *s_fused_emitter = NULL;
+static VertexStream s_fused_streams[NUM_SLOTS];
+
+/* When all the attributes of a glDrawElements() call can be read by the GPU
+ * directly from the client arrays, we just send the indices. This holds the
+ * GX input mode (GX_INDEX8 or GX_INDEX16) in that case, GX_DIRECT otherwise. */
+static uint8_t s_indexed_inputmode = GX_DIRECT;
+
 static inline VertexReaderBase *get_reader(OgxArrayReader *reader)
 {
     return reinterpret_cast<VertexReaderBase *>(reader);
 }
 
+/* Returns the number of components of the stream if the fused emitters
+ * support its format, or 0 otherwise */
+static int fused_stream_components(const VertexStream &stream)
+{
+    const GxVertexFormat &format = stream.format;
+    switch (format.attribute) {
+    case GX_VA_POS:
+        return format.size == GX_F32 ? format.num_components : 0;
+    case GX_VA_NRM:
+        return format.size == GX_F32 && format.num_components == 3 ? 3 : 0;
+    case GX_VA_CLR0:
+        return format.size == GX_RGBA8 || format.size == GX_RGB8 ?
+            format.num_components : 0;
+    case GX_VA_TEX0:
+        return format.size == GX_F32 && format.num_components == 2 ? 2 : 0;
+    }
+    return 0;
+}
+
+static const FusedEmitter *select_fused_emitter(int num_arrays)
+{
+    if (s_indexed_inputmode != GX_DIRECT) {
+        return &s_indexed_emitters[s_indexed_inputmode == GX_INDEX8]
+                                  [num_arrays - 1];
+    }
+
+    VertexStream stream;
+    VertexStreamKind kind = get_reader(&s_readers[0])->get_stream(&stream);
+
+    if (kind == STREAM_INDEX16) {
+        if (num_arrays > NUM_SLOTS) return NULL;
+        for (int i = 1; i < num_arrays; i++) {
+            if (get_reader(&s_readers[i])->get_stream(&stream) !=
+                STREAM_INDEX16) return NULL;
+        }
+        return &s_indexed_emitters[0][num_arrays - 1];
+    }
+
+    if (kind != STREAM_DIRECT) return NULL;
+    if (num_arrays > 1 && (s_num_colors > 1 || s_num_tex_arrays > 1))
+        return NULL;
+
+    int components[NUM_SLOTS] = { 0, 0, 0, 0 };
+    for (int i = 0; i < num_arrays; i++) {
+        if (get_reader(&s_readers[i])->get_stream(&stream) != STREAM_DIRECT)
+            return NULL;
+
+        int slot;
+        switch (stream.format.attribute) {
+        case GX_VA_POS: slot = SLOT_POS; break;
+        case GX_VA_NRM: slot = SLOT_NRM; break;
+        case GX_VA_CLR0: slot = SLOT_CLR; break;
+        case GX_VA_TEX0: slot = SLOT_TEX; break;
+        default: return NULL;
+        }
+        components[slot] = fused_stream_components(stream);
+        if (components[slot] == 0) return NULL;
+        s_fused_streams[slot] = stream;
+    }
+
+    if (components[SLOT_POS] < 2 || components[SLOT_POS] > 3) return NULL;
+    return &s_direct_emitters[components[SLOT_POS] - 2]
+                             [components[SLOT_NRM] / 3]
+                             [components[SLOT_CLR] ?
+                              components[SLOT_CLR] - 2 : 0]
+                             [components[SLOT_TEX] / 2];
+}
+
+/* Draw batching: the vertex data of consecutive draws using the same vertex
+ * format is copied into a buffer, laid out as the fused emitter expects it,
+ * and emitted at once by _ogx_arrays_batch_emit(). */
+static struct {
+    /* The emitter identifies the vertex format */
+    const FusedEmitter *emitter;
+    VertexStream streams[NUM_SLOTS];
+    int offsets[NUM_SLOTS];
+    int sizes[NUM_SLOTS];
+    int vertex_size;
+    int count;
+    int capacity;
+    char *data;
+} s_batch;
+
+static bool is_direct_emitter(const FusedEmitter *emitter)
+{
+    const FusedEmitter *start = &s_direct_emitters[0][0][0][0];
+    return emitter >= start &&
+        emitter < start + sizeof(s_direct_emitters) / sizeof(FusedEmitter);
+}
+
+static void batch_setup_layout(const FusedEmitter *emitter)
+{
+    s_batch.emitter = emitter;
+    s_batch.vertex_size = 0;
+    for (int slot = 0; slot < NUM_SLOTS; slot++) {
+        int components = s_fused_streams[slot].data ?
+            fused_stream_components(s_fused_streams[slot]) : 0;
+        int size = slot == SLOT_CLR ? components : components * sizeof(float);
+        s_batch.streams[slot].format = s_fused_streams[slot].format;
+        s_batch.offsets[slot] = s_batch.vertex_size;
+        s_batch.sizes[slot] = size;
+        s_batch.vertex_size += size;
+    }
+}
+
+bool _ogx_arrays_batch_append(int first, int count)
+{
+    if (s_draw_flags & (OGX_DRAW_FLAG_FLAT | OGX_DRAW_FLAG_MATRIX_INDEX))
+        return false;
+
+    /* Only the vertex formats handled by the direct emitters are supported */
+    s_indexed_inputmode = GX_DIRECT;
+    memset(s_fused_streams, 0, sizeof(s_fused_streams));
+    const FusedEmitter *emitter = select_fused_emitter(count_attributes());
+    if (!is_direct_emitter(emitter)) return false;
+
+    if (s_batch.count == 0) {
+        batch_setup_layout(emitter);
+    } else if (emitter != s_batch.emitter) {
+        return false;
+    }
+
+    int needed = (s_batch.count + count) * s_batch.vertex_size;
+    if (needed > s_batch.capacity) {
+        int capacity = needed * 2;
+        char *data = (char *)realloc(s_batch.data, capacity);
+        if (!data) return false;
+        s_batch.data = data;
+        s_batch.capacity = capacity;
+    }
+
+    char *dst = s_batch.data + s_batch.count * s_batch.vertex_size;
+    for (int i = first; i < first + count; i++) {
+        for (int slot = 0; slot < NUM_SLOTS; slot++) {
+            int size = s_batch.sizes[slot];
+            if (size == 0) continue;
+            const VertexStream &stream = s_fused_streams[slot];
+            memcpy(dst + s_batch.offsets[slot],
+                   stream.data + stream.stride * i, size);
+        }
+        dst += s_batch.vertex_size;
+    }
+    s_batch.count += count;
+    return true;
+}
+
+int _ogx_arrays_batch_count()
+{
+    return s_batch.count;
+}
+
+void _ogx_arrays_batch_emit()
+{
+    for (int slot = 0; slot < NUM_SLOTS; slot++) {
+        s_batch.streams[slot].data = s_batch.data + s_batch.offsets[slot];
+        s_batch.streams[slot].stride = s_batch.vertex_size;
+    }
+    s_batch.emitter->emit_range(s_batch.streams, 0, s_batch.count, false);
+    s_batch.count = 0;
+}
+
+static void index_range(const void *indices, GLenum type, int count,
+                        int *min_index, int *max_index)
+{
+    int min = INT_MAX, max = 0;
+    for (int i = 0; i < count; i++) {
+        int index = read_index(indices, type, i);
+        if (index < min) min = index;
+        if (index > max) max = index;
+    }
+    *min_index = min;
+    *max_index = max;
+}
+
+/* Checks whether the GPU can read all the vertex attributes from arrays, and
+ * in that case sets them up and returns the input mode to be used for the
+ * indices. The arrays are set to start at the lowest index, so that 8-bit
+ * indices can be used whenever the index range is small enough. */
+static uint8_t setup_indexed_arrays(const OgxDrawData *draw_data,
+                                    int num_arrays)
+{
+    if (!draw_data->indices || draw_data->count <= 0 ||
+        num_arrays > NUM_SLOTS) return GX_DIRECT;
+
+    VertexStream streams[NUM_SLOTS];
+    VertexStreamKind kinds[NUM_SLOTS];
+    bool has_client_arrays = false;
+    for (int i = 0; i < num_arrays; i++) {
+        kinds[i] = get_reader(&s_readers[i])->get_stream(&streams[i]);
+        if (kinds[i] == STREAM_DIRECT) {
+            /* Constant values (stride 0) cannot be used, since they are stored
+             * in the reader itself, which will be reused by the next draw;
+             * also, GX supports strides of up to 255 bytes only. */
+            if (streams[i].stride == 0 || streams[i].stride > 255)
+                return GX_DIRECT;
+            has_client_arrays = true;
+        } else if (kinds[i] != STREAM_INDEX16) {
+            return GX_DIRECT;
+        }
+    }
+    if (has_client_arrays &&
+        !(glparamstate.hints & OGX_HINT_INDEXED_CLIENT_ARRAYS))
+        return GX_DIRECT;
+
+    int min_index, max_index;
+    if (draw_data->has_index_range) {
+        min_index = draw_data->min_index;
+        max_index = draw_data->max_index;
+    } else if (has_client_arrays) {
+        index_range(draw_data->indices, draw_data->type, draw_data->count,
+                    &min_index, &max_index);
+    } else {
+        /* If all data comes from VBOs we are already sending 16-bit indices,
+         * and scanning them to find out their range is not worth it */
+        return GX_DIRECT;
+    }
+
+    /* The maximum value of an index is reserved by GX to skip a vertex */
+    uint8_t inputmode;
+    if (max_index - min_index < 0xff) {
+        inputmode = GX_INDEX8;
+    } else if (max_index - min_index < 0xffff) {
+        inputmode = GX_INDEX16;
+    } else {
+        return GX_DIRECT;
+    }
+    /* With VBOs only, we'd be sending 16-bit indices anyway */
+    if (!has_client_arrays && inputmode != GX_INDEX8) return GX_DIRECT;
+
+    for (int i = 0; i < num_arrays; i++) {
+        const VertexStream &stream = streams[i];
+        const GxVertexFormat &format = stream.format;
+        if (kinds[i] == STREAM_DIRECT) {
+            /* Make sure that the GPU sees the latest data */
+            DCFlushRange((void *)(stream.data + min_index * stream.stride),
+                         (max_index - min_index) * stream.stride +
+                         format.stride());
+        }
+        GX_SetArray(format.attribute,
+                    const_cast<char*>(stream.data + min_index * stream.stride),
+                    stream.stride);
+        GX_SetVtxDesc(format.attribute, inputmode);
+        s_vertex_layout.add(format);
+    }
+    s_index_base = min_index;
+    return inputmode;
+}
+
 void _ogx_arrays_setup_draw(const OgxDrawData *draw_data,
                             OgxDrawFlags flags)
 {
     GX_ClearVtxDesc();
+    s_vertex_layout.clear();
 
     s_draw_flags = flags;
+    if (flags & OGX_DRAW_FLAG_MATRIX_INDEX)
+        GX_SetVtxDesc(GX_VA_PTNMTXIDX, GX_DIRECT);
 
     int num_arrays = s_draw_flags & OGX_DRAW_FLAG_FLAT ?
         1 : count_attributes();
 
-    for (int i = 0; i < num_arrays; i++) {
-        VertexReaderBase *r = get_reader(&s_readers[i]);
-        r->setup_draw();
+    s_index_base = 0;
+    s_indexed_inputmode = setup_indexed_arrays(draw_data, num_arrays);
+    if (s_indexed_inputmode == GX_DIRECT) {
+        for (int i = 0; i < num_arrays; i++) {
+            VertexReaderBase *r = get_reader(&s_readers[i]);
+            r->setup_draw();
+        }
     }
+    s_vtxfmt = vtxfmt_for_layout(s_vertex_layout);
+
+    s_fused_emitter = select_fused_emitter(num_arrays);
+}
+
+uint8_t _ogx_arrays_vtxfmt()
+{
+    return s_vtxfmt;
 }
 
 void _ogx_arrays_process_element(int index)
@@ -644,6 +1384,91 @@ void _ogx_arrays_process_element(int index)
     }
 }
 
+void _ogx_arrays_set_matrix_index(uint8_t pnmtx)
+{
+    s_matrix_index = pnmtx;
+    s_matrix_palette.indices = NULL;
+}
+
+void _ogx_arrays_set_matrix_palette(const void *indices, GLenum type,
+                                    int stride, const uint8_t *pnmtx,
+                                    int count)
+{
+    s_matrix_palette.is_short = type == GL_UNSIGNED_SHORT;
+    s_matrix_palette.stride = stride > 0 ?
+        stride : (s_matrix_palette.is_short ? 2 : 1);
+    s_matrix_palette.indices = static_cast<const uint8_t *>(indices);
+    s_matrix_palette.pnmtx = pnmtx;
+    s_matrix_palette.count = count;
+}
+
+/* Emits a single vertex, preceded by the position matrix index */
+static void emit_vertex_with_matrix_index(int index)
+{
+    uint8_t pnmtx = s_matrix_index;
+    if (s_matrix_palette.indices) {
+        const uint8_t *ptr =
+            s_matrix_palette.indices + index * s_matrix_palette.stride;
+        int entry = s_matrix_palette.is_short ?
+            *reinterpret_cast<const uint16_t *>(ptr) : *ptr;
+        pnmtx = s_matrix_palette.pnmtx[entry < s_matrix_palette.count ?
+                                       entry : 0];
+    }
+    GX_MatrixIndex1x8(pnmtx);
+    if (s_fused_emitter) {
+        s_fused_emitter->emit_range(s_fused_streams, index, 1, false);
+    } else {
+        _ogx_arrays_process_element(index);
+    }
+}
+
+void _ogx_arrays_emit_range(int first, int count, bool loop)
+{
+    if (s_draw_flags & OGX_DRAW_FLAG_MATRIX_INDEX) {
+        for (int i = 0; i < count + loop; i++) {
+            emit_vertex_with_matrix_index(i % count + first);
+        }
+        return;
+    }
+
+    if (s_fused_emitter) {
+        s_fused_emitter->emit_range(s_fused_streams, first, count, loop);
+        return;
+    }
+
+    for (int i = 0; i < count + loop; i++) {
+        _ogx_arrays_process_element(i % count + first);
+    }
+}
+
+void _ogx_arrays_emit_elements(const void *indices, GLenum type, int count,
+                               bool loop)
+{
+    if (s_draw_flags & OGX_DRAW_FLAG_MATRIX_INDEX) {
+        for (int i = 0; i < count + loop; i++) {
+            emit_vertex_with_matrix_index(read_index(indices, type, i % count));
+        }
+        return;
+    }
+
+    if (s_fused_emitter) {
+        int type_index;
+        switch (type) {
+        case GL_UNSIGNED_BYTE: type_index = 0; break;
+        case GL_UNSIGNED_SHORT: type_index = 1; break;
+        default: type_index = 2; break;
+        }
+        s_fused_emitter->emit_elements[type_index](s_fused_streams, indices,
+                                                   count, loop);
+        return;
+    }
+
+    for (int i = 0; i < count + loop; i++) {
+        int index = read_index(indices, type, i % count);
+        _ogx_arrays_process_element(index);
+    }
+}
+
 void _ogx_arrays_draw_done()
 {
     int num_arrays = count_attributes();
@@ -787,6 +1612,40 @@ OgxArrayReader *_ogx_array_add(uint8_t attribute, const OgxVertexAttribArray *ar
 
     GLenum type = array->type;
     int stride = array->stride;
+
+    float max_error = array->vbo && can_quantize(array, attribute) ?
+        _ogx_vbo_get_max_error(array->vbo) : 0.0f;
+    if (array->vbo && (!info.same_type || compute_array_stride(array) > 255 ||
+                       max_error > 0.0f)) {
+        /* GX cannot read this data directly (or it does not support the
+         * stride, or the client asked for quantization), but we can convert
+         * it once and let GX read the converted copy. */
+        OgxVboConvertFunc convert = max_error > 0.0f ?
+            quantize_to_shadow : shadow_converter(type);
+        OgxVboShadowKey key = {
+            uintptr_t(array->pointer),
+            uint16_t(compute_array_stride(array)),
+            uint16_t(type),
+            uint8_t(array->size),
+            info.format.attribute,
+            max_error,
+        };
+        GxVertexFormat format = shadow_format(info.format);
+        OgxVboShadowFormat shadow_fmt = {
+            uint8_t(format.stride()), format.size, 0
+        };
+        void *shadow = convert ?
+            _ogx_vbo_get_shadow_data(array->vbo, &key,
+                                     sizeof_gl_type(type) * array->size,
+                                     &shadow_fmt, convert) : NULL;
+        if (shadow) {
+            format.size = shadow_fmt.size;
+            format.frac = shadow_fmt.frac;
+            new (reader) DirectVboReader(array->vbo, format, shadow, 0);
+            return reader;
+        }
+    }
+
     const void *data = array->vbo ?
         _ogx_vbo_get_data(array->vbo, array->pointer) : array->pointer;
 
@@ -906,7 +1765,7 @@ OgxArrayReader *_ogx_array_reader_for_attribute(uint8_t attribute)
 
 void _ogx_array_reader_get_format(OgxArrayReader *reader,
                                   uint8_t *attribute, uint8_t *inputmode,
-                                  uint8_t *type, uint8_t *size)
+                                  uint8_t *type, uint8_t *size, uint8_t *frac)
 {
-    get_reader(reader)->get_format(attribute, inputmode, type, size);
+    get_reader(reader)->get_format(attribute, inputmode, type, size, frac);
 }
@@ -44,17 +44,50 @@ extern "C" {
 
 typedef struct {
     /* Opaque struct */
-    uint32_t reader[6];
+    void *reader[6];
 } OgxArrayReader;
 
 typedef enum {
     OGX_DRAW_FLAG_NONE = 0,
     OGX_DRAW_FLAG_FLAT = 1 << 0,
+    /* Each vertex is preceded by a position matrix index (see
+     * _ogx_arrays_set_matrix_index()) */
+    OGX_DRAW_FLAG_MATRIX_INDEX = 1 << 1,
 } OgxDrawFlags;
 
 void _ogx_arrays_setup_draw(const OgxDrawData *draw_data, OgxDrawFlags flags);
+/* The GX_VTXFMT* slot holding the vertex format set up by the last call to
+ * _ogx_arrays_setup_draw(); to be passed to GX_Begin(). */
+uint8_t _ogx_arrays_vtxfmt(void);
 
 void _ogx_arrays_process_element(int index);
+/* Emit the vertex data for all the vertices in the given range, or in the
+ * given index array. If loop is true, the first vertex is emitted again at the
+ * end. These are faster than calling _ogx_arrays_process_element() in a loop,
+ * because they use a specialised emitter when the vertex format allows it. */
+void _ogx_arrays_emit_range(int first, int count, bool loop);
+void _ogx_arrays_emit_elements(const void *indices, GLenum type, int count,
+                               bool loop);
+/* Sets the position matrix (GX_PNMTX*) used by the vertices emitted by the
+ * functions above, if OGX_DRAW_FLAG_MATRIX_INDEX was given to
+ * _ogx_arrays_setup_draw() */
+void _ogx_arrays_set_matrix_index(uint8_t pnmtx);
+/* Like _ogx_arrays_set_matrix_index(), but the matrix is chosen per vertex:
+ * the vertex index is used to read a palette index (of the given type, either
+ * GL_UNSIGNED_BYTE or GL_UNSIGNED_SHORT) from the indices array, which is
+ * then mapped to a GX_PNMTX* value through the pnmtx array. Palette indices
+ * not lower than count select pnmtx[0]. */
+void _ogx_arrays_set_matrix_palette(const void *indices, GLenum type,
+                                    int stride, const uint8_t *pnmtx,
+                                    int count);
+/* Draw batching: copy the vertex data of the given range into the batch
+ * buffer. Returns false if the current vertex format cannot be batched, or if
+ * it differs from the format of the vertices already in the batch. */
+bool _ogx_arrays_batch_append(int first, int count);
+/* Number of vertices in the batch buffer */
+int _ogx_arrays_batch_count(void);
+/* Emits all the vertices in the batch buffer, and empties it */
+void _ogx_arrays_batch_emit(void);
 /* Any memory allocated by the OgxArrayReader objects can be released. */
 void _ogx_arrays_draw_done();
 void _ogx_array_reader_process_element(OgxArrayReader *reader, int index);
@@ -93,10 +126,11 @@ OgxArrayReader *_ogx_array_reader_for_attribute(uint8_t attribute);
  * - inputmode: libogc's vtxattrin
  * - type: libogc's comptype
  * - size: libogc's comptype
+ * - frac: the number of fractional bits of fixed point data
  */
 void _ogx_array_reader_get_format(OgxArrayReader *reader,
                                   uint8_t *attribute, uint8_t *inputmode,
-                                  uint8_t *type, uint8_t *size);
+                                  uint8_t *type, uint8_t *size, uint8_t *frac);
 
 #ifdef __cplusplus
 } // extern C
@@ -34,21 +34,46 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "debug.h"
 #include "efb.h"
 #include "gpu_resources.h"
+#include "id_allocator.h"
 #include "opengx.h"
 #include "stencil.h"
+#include "texture.h"
 #include "utils.h"
+#include "wireframe.h"
 
 #include <GL/gl.h>
 #include <assert.h>
 #include <malloc.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 
-#define MAX_COMMANDS_PER_BUFFER 4
+/* Initial capacity of the command array of a list; it doubles when full */
+#define MIN_COMMANDS_PER_LIST 16
 #define MAX_CALL_LISTS 1536
-/* The glut teapot can take more than 300KB, for reference */
-#define MAX_GXLIST_SIZE (1024 * 1024)
+/* GX lists are allocated from chunks of this size; lists larger than half of
+ * it get a chunk of their own. For reference, the glut teapot can take more
+ * than 300KB. */
+#define GXLIST_CHUNK_SIZE (64 * 1024)
+/* libogc detects a display list overflow by checking whether the FIFO
+ * wrapped, so leave some headroom after the expected end of the list. */
+#define GXLIST_HEADROOM 32
 #define CALL_LIST_START_ID 1
+/* Maximum size of the GX list holding the render state baked into a draw */
+#define STATE_GXLIST_SIZE 4096
+/* Maximum depth of the called lists inlined by flatten_list() */
+#define MAX_INLINE_DEPTH 64
+
+/* Chunks are freed as soon as none of their memory is referenced by a GX
+ * list: since lists are usually created and deleted in groups, this keeps
+ * fragmentation low without the complexity of a general purpose allocator. */
+typedef struct GXListChunk {
+    u32 size; /* capacity of data[] */
+    u32 used; /* the bump pointer */
+    u32 live; /* bytes still referenced by some list */
+    _Alignas(32) u8 data[0];
+} GXListChunk;
 
 typedef struct
 {
@@ -104,15 +129,29 @@ typedef struct
         struct DrawGeometry {
             GLenum mode;
             uint16_t count;
+            uint16_t vertex_size; /* bytes per vertex in the GX list */
             union client_state cs;
             u32 list_size;
             void *gxlist;
+            GXListChunk *chunk;
+            /* Copies of gxlist drawing a different GX primitive (see
+             * gxlist_for_mode()) */
+            void *mode_gxlists[2];
+            GXListChunk *mode_chunks[2];
+            u32 mode_list_sizes[2];
+            /* The render state, if baked (see OGX_HINT_BAKE_CALL_LISTS) */
+            u32 state_size;
+            void *state_gxlist;
+            GXListChunk *state_chunk;
+            /* NULL if the baked state samples no textures */
+            struct BakedTextures *baked_textures;
             struct AttribFormat {
                 unsigned attribute : 5;
                 /* Most of these only require 2-3 bits, but let's round it */
                 unsigned inputmode : 3;
                 unsigned comptype : 4;
                 unsigned compsize : 4;
+                unsigned frac : 5;
             } formats[4 + MAX_TEXTURE_UNITS]; /* 4: pos, norm, clr1 and clr2 */
             #define CALL_LIST_DRAW_FORMATS(fmt) (sizeof(fmt) / sizeof(fmt[0]))
         } draw_geometry;
@@ -125,120 +164,154 @@ typedef struct
     } c;
 } Command;
 
-typedef struct CommandBuffer
-{
-    Command commands[MAX_COMMANDS_PER_BUFFER];
-    struct CommandBuffer *next;
-} CommandBuffer;
-
 typedef struct
 {
-    CommandBuffer *head;
+    /* NULL if the list is free, 1 if reserved but still without commands */
+    Command *commands;
+    u32 num_commands;
+    u32 capacity;
+    /* Size of the GX display lists owned by this list */
+    u32 gx_bytes;
+    /* The commands with the called lists inlined, run instead of the commands
+     * above if not NULL (see flatten_list()) */
+    Command *flat_commands;
+    u32 num_flat_commands;
+    /* Indexes of the lists whose commands were inlined */
+    u16 *inlined;
+    u32 num_inlined;
+    bool must_flatten;
+    /* Whether the commands run by the list leave the GX vertex descriptors
+     * and formats as set up by its last draw (see keeps_vertex_setup()) */
+    bool keeps_vertex_setup;
 } CallList;
 
 static CallList call_lists[MAX_CALL_LISTS];
-static GXColor s_current_color;
-static float s_current_normal[3];
-static bool s_last_draw_used_indexed_data = false;
-static uint16_t s_last_draw_sync_token = 0;
+OGX_ID_ALLOCATOR(s_list_ids, MAX_CALL_LISTS);
+static GXListChunk *s_current_chunk = NULL;
+static int s_num_flat_lists = 0;
+/* The current normal and color are fed to the lists through indexed arrays.
+ * Since the GPU might still be reading a slot while the CPU moves on to the
+ * next draws, they are written into a ring of slots. */
+#define CURRENT_ATTR_SLOTS 64
+typedef struct {
+    float normal[3];
+    GXColor color;
+    u8 padding[16];
+} CurrentAttributes;
+static CurrentAttributes s_current_attrs[CURRENT_ATTR_SLOTS]
+    ATTRIBUTE_ALIGN(32);
+static int s_current_attr_slot = -1;
+static uint16_t s_attr_half_tokens[2] = { 0, 0 };
+/* The vertex setup done by the last draw: both the client state and the
+ * formats must match for the next draw to reuse it */
 static union client_state s_last_client_state;
+static struct AttribFormat s_last_formats[4 + MAX_TEXTURE_UNITS];
 static bool s_last_client_state_is_valid = false;
+/* True while glCallLists() is running its lists */
+static bool s_calling_lists = false;
+
+#define COMMANDS_ARE_VALID(commands) (((uintptr_t)commands) > 1)
+#define LIST_IS_USED(index) COMMANDS_ARE_VALID(call_lists[index].commands)
+#define LIST_IS_RESERVED_OR_USED(index) (call_lists[index].commands != NULL)
+#define LIST_RESERVE(index) \
+    { \
+        call_lists[index].commands = (void*)1; \
+        _ogx_id_take(&s_list_ids, index); \
+    }
+#define LIST_UNRESERVE(index) \
+    { \
+        call_lists[index].commands = NULL; \
+        _ogx_id_release(&s_list_ids, index); \
+    }
 
-#define BUFFER_IS_VALID(buffer) (((uint32_t)buffer) > 1)
-#define LIST_IS_USED(index) BUFFER_IS_VALID(call_lists[index].head)
-#define LIST_IS_RESERVED_OR_USED(index) (call_lists[index].head != NULL)
-#define LIST_RESERVE(index) call_lists[index].head = (void*)1
-#define LIST_UNRESERVE(index) call_lists[index].head = NULL
+static GXListChunk *gxlist_chunk_new(u32 size)
+{
+    GXListChunk *chunk = memalign(32, sizeof(GXListChunk) + size);
+    if (!chunk) return NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->live = 0;
+    return chunk;
+}
 
-static inline int last_command(CommandBuffer **buffer)
+/* Returns 32-byte aligned memory for a GX list of the given size; the chunk
+ * it belongs to is stored into chunk_out. */
+static void *gxlist_alloc(u32 size, GXListChunk **chunk_out)
 {
-    CommandBuffer *next;
+    GXListChunk *chunk;
 
-    while (BUFFER_IS_VALID(*buffer)) {
-        next = (*buffer)->next;
-        if (!next) {
-            for (int i = 0; i < MAX_COMMANDS_PER_BUFFER; i++) {
-                Command *curr = &(*buffer)->commands[i];
-                if (curr->type == COMMAND_NONE) {
-                    return i - 1;
-                }
-            }
-            return MAX_COMMANDS_PER_BUFFER - 1;
+    size = ROUND_UP(size, 32);
+    if (size > GXLIST_CHUNK_SIZE / 2) {
+        chunk = gxlist_chunk_new(size);
+    } else {
+        chunk = s_current_chunk;
+        if (!chunk || chunk->size - chunk->used < size) {
+            if (chunk && chunk->live == 0) free(chunk);
+            chunk = s_current_chunk = gxlist_chunk_new(GXLIST_CHUNK_SIZE);
         }
-
-        *buffer = next;
+    }
+    if (!chunk) {
+        warning("Failed to allocate memory for GX list (%d)", errno);
+        return NULL;
     }
 
-    return -1;
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    chunk->live += size;
+    *chunk_out = chunk;
+    return ptr;
 }
 
-static Command *new_command(CommandBuffer **head)
+static void gxlist_free(GXListChunk *chunk, u32 size)
 {
-    int last_index = -1;
-    CommandBuffer *last_buffer = NULL;
-
-    if (BUFFER_IS_VALID(*head)) {
-        last_buffer = *head;
-        last_index = last_command(&last_buffer);
-    }
-
-    if (last_index < 0 || last_index == MAX_COMMANDS_PER_BUFFER - 1) {
-        CommandBuffer *new_buffer = malloc(sizeof(CommandBuffer));
-        if (!new_buffer) {
-            warning("Failed to allocate memory for call-list buffer (%d)", errno);
-            return NULL;
-        }
-
-        for (int i = 0; i < MAX_COMMANDS_PER_BUFFER; i++) {
-            new_buffer->commands[i].type = COMMAND_NONE;
-        }
-        new_buffer->next = NULL;
+    chunk->live -= ROUND_UP(size, 32);
+    if (chunk->live > 0) return;
 
-        if (last_buffer) {
-            last_buffer->next = new_buffer;
-        } else {
-            *head = new_buffer;
-        }
-        return &new_buffer->commands[0];
+    if (chunk == s_current_chunk) {
+        chunk->used = 0;
     } else {
-        return &last_buffer->commands[last_index + 1];
+        free(chunk);
     }
 }
 
-static void setup_draw_geometry(struct DrawGeometry *dg,
-                                bool uses_indexed_data)
+/* Give back the unused tail of the last allocation, if it's still at the top
+ * of its chunk. */
+static void gxlist_shrink(GXListChunk *chunk, void *ptr,
+                          u32 old_size, u32 new_size)
 {
-    u8 vtxindex = GX_VTXFMT0;
-    GXColor current_color;
+    old_size = ROUND_UP(old_size, 32);
+    new_size = ROUND_UP(new_size, 32);
+    if ((u8 *)ptr + old_size != chunk->data + chunk->used) return;
 
-    if (uses_indexed_data && s_last_draw_used_indexed_data) {
-        bool data_changed = false;
-        /* If the indexed data has changed, we need to wait until the previous
-         * list has completed its execution, because changing the data under
-         * its feet will cause rendering issues. */
-        if (!dg->cs.color_enabled) {
-            current_color = gxcol_new_fv(glparamstate.imm_mode.current_color);
-            if (!gxcol_equal(current_color, s_current_color)) data_changed = true;
-        }
-
-        if (!dg->cs.normal_enabled) {
-            if (memcmp(s_current_normal, glparamstate.imm_mode.current_normal,
-                       sizeof(s_current_normal)) != 0)
-                data_changed = true;
-        }
+    chunk->used -= old_size - new_size;
+    chunk->live -= old_size - new_size;
+}
 
-        if (data_changed) {
-            // Wait
-            while (GX_GetDrawSync() < s_last_draw_sync_token);
+static Command *new_command(CallList *list)
+{
+    if (list->num_commands == list->capacity) {
+        u32 capacity = list->capacity > 0 ?
+            list->capacity * 2 : MIN_COMMANDS_PER_LIST;
+        Command *commands = COMMANDS_ARE_VALID(list->commands) ?
+            list->commands : NULL;
+        commands = realloc(commands, capacity * sizeof(Command));
+        if (!commands) {
+            warning("Failed to allocate memory for call-list commands (%d)",
+                    errno);
+            return NULL;
         }
+        list->commands = commands;
+        list->capacity = capacity;
     }
+    /* Clear the unused bytes too, so that commands can be compared with
+     * memcmp() */
+    Command *command = &list->commands[list->num_commands++];
+    memset(command, 0, sizeof(Command));
+    return command;
+}
 
-    OgxDrawMode gxmode = _ogx_draw_mode(dg->mode);
-    OgxDrawData draw_data = {
-        gxmode,
-        dg->count,
-        /* The remaining fields are not used when drawing through lists */
-    };
+static void setup_draw_geometry(struct DrawGeometry *dg)
+{
     /* Setup the same vertex attribute descriptions that were in place when the
      * list was created */
     GX_ClearVtxDesc();
@@ -247,26 +320,19 @@ static void setup_draw_geometry(struct DrawGeometry *dg,
         uint8_t attribute = dg->formats[i].attribute;
         GX_SetVtxDesc(attribute, dg->formats[i].inputmode);
         GX_SetVtxAttrFmt(GX_VTXFMT0, attribute,
-                         dg->formats[i].comptype, dg->formats[i].compsize, 0);
+                         dg->formats[i].comptype, dg->formats[i].compsize,
+                         dg->formats[i].frac);
     }
 
     if (!dg->cs.normal_enabled) {
         GX_SetVtxDesc(GX_VA_NRM, GX_INDEX8);
         GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_NRM, GX_NRM_XYZ, GX_F32, 0);
-        GX_SetArray(GX_VA_NRM, s_current_normal, 12);
-        floatcpy(s_current_normal, glparamstate.imm_mode.current_normal, 3);
-        /* Not needed on Dolphin, but it is on a Wii */
-        DCStoreRange(s_current_normal, 12);
     }
     if (!dg->cs.color_enabled) {
         GX_SetVtxDesc(GX_VA_CLR0, GX_INDEX8);
         GX_SetVtxDesc(GX_VA_CLR1, GX_INDEX8);
         GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGB8, 0);
         GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR1, GX_CLR_RGBA, GX_RGB8, 0);
-        s_current_color = current_color;
-        GX_SetArray(GX_VA_CLR0, &s_current_color, 4);
-        GX_SetArray(GX_VA_CLR1, &s_current_color, 4);
-        DCStoreRange(&s_current_color, 4);
     }
 
     /* It makes no sense to use a fixed texture coordinates for all vertices,
@@ -275,82 +341,347 @@ static void setup_draw_geometry(struct DrawGeometry *dg,
     GX_InvVtxCache();
 }
 
-static void execute_draw_geometry_list(struct DrawGeometry *dg)
+static CurrentAttributes *next_current_attributes()
+{
+    const int half_size = CURRENT_ATTR_SLOTS / 2;
+
+    s_current_attr_slot = (s_current_attr_slot + 1) % CURRENT_ATTR_SLOTS;
+    if (s_current_attr_slot % half_size == 0) {
+        /* Before reusing this half of the ring, the GPU must be done with the
+         * draws which used it in the previous round: they were all issued
+         * before the token marking the start of the other half. This
+         * normally never waits. */
+        int half = s_current_attr_slot / half_size;
+        uint16_t token = s_attr_half_tokens[1 - half];
+        if (token > _ogx_draw_sync_token_received) {
+            while (GX_GetDrawSync() < token);
+        }
+        s_attr_half_tokens[half] = send_draw_sync_token();
+    }
+    return &s_current_attrs[s_current_attr_slot];
+}
+
+/* Points the indexed normal and color arrays used by the list to the current
+ * values. The list itself is never modified. */
+static void update_current_attributes(struct DrawGeometry *dg)
+{
+    CurrentAttributes *attrs = s_current_attr_slot >= 0 ?
+        &s_current_attrs[s_current_attr_slot] : NULL;
+    GXColor current_color = gxcol_new_fv(glparamstate.imm_mode.current_color);
+    const float *current_normal = glparamstate.imm_mode.current_normal;
+
+    /* Only take a new slot if the values have changed */
+    if (!attrs ||
+        (!dg->cs.color_enabled &&
+         !gxcol_equal(current_color, attrs->color)) ||
+        (!dg->cs.normal_enabled &&
+         memcmp(attrs->normal, current_normal, sizeof(attrs->normal)) != 0)) {
+        attrs = next_current_attributes();
+        floatcpy(attrs->normal, current_normal, 3);
+        attrs->color = current_color;
+        /* Not needed on Dolphin, but it is on a Wii */
+        DCStoreRange(attrs, sizeof(CurrentAttributes));
+    }
+
+    if (!dg->cs.normal_enabled) {
+        GX_SetArray(GX_VA_NRM, attrs->normal, 12);
+    }
+    if (!dg->cs.color_enabled) {
+        GX_SetArray(GX_VA_CLR0, &attrs->color, 4);
+        GX_SetArray(GX_VA_CLR1, &attrs->color, 4);
+    }
+}
+
+static void execute_draw_geometry_list(struct DrawGeometry *dg,
+                                       void *gxlist, u32 size)
 {
-    bool uses_indexed_data = !dg->cs.normal_enabled || !dg->cs.color_enabled;
     if (!s_last_client_state_is_valid ||
-        s_last_client_state.as_int != dg->cs.as_int) {
-        setup_draw_geometry(dg, uses_indexed_data);
+        s_last_client_state.as_int != dg->cs.as_int ||
+        memcmp(s_last_formats, dg->formats, sizeof(s_last_formats)) != 0) {
+        setup_draw_geometry(dg);
         s_last_client_state = dg->cs;
+        memcpy(s_last_formats, dg->formats, sizeof(s_last_formats));
         s_last_client_state_is_valid = true;
     }
 
-    GX_CallDispList(dg->gxlist, dg->list_size);
-
-    if (uses_indexed_data) {
-        s_last_draw_sync_token = send_draw_sync_token();
-        s_last_draw_used_indexed_data = true;
-    } else {
-        s_last_draw_used_indexed_data = false;
+    if (!dg->cs.normal_enabled || !dg->cs.color_enabled) {
+        update_current_attributes(dg);
     }
+
+    GX_CallDispList(gxlist, size);
 }
 
+typedef struct {
+    struct DrawGeometry *dg;
+    void *gxlist;
+    u32 size;
+} FlatDrawData;
+
 static void flat_draw_geometry(void *cb_data)
 {
-    struct DrawGeometry *dg = cb_data;
-    execute_draw_geometry_list(dg);
+    FlatDrawData *data = cb_data;
+    execute_draw_geometry_list(data->dg, data->gxlist, data->size);
+}
+
+/* Flags the GX state written by the lists baked by bake_draw_state() as
+ * needing an update */
+static void mark_baked_state_dirty()
+{
+    glparamstate.dirty.bits.dirty_alphatest = 1;
+    glparamstate.dirty.bits.dirty_blend = 1;
+    glparamstate.dirty.bits.dirty_z = 1;
+    glparamstate.dirty.bits.dirty_color_update = 1;
+    glparamstate.dirty.bits.dirty_tev = 1;
+    glparamstate.dirty.bits.dirty_cull = 1;
+    glparamstate.dirty.bits.dirty_fog = 1;
+}
+
+/* The textures whose GXTexObj were loaded by a baked render state */
+typedef struct BakedTextures {
+    unsigned units;
+    GLuint names[MAX_TEXTURE_UNITS];
+    GXTexObj texobjs[MAX_TEXTURE_UNITS];
+} BakedTextures;
+
+/* Stores the textures sampled by the current state into *out, or NULL if there
+ * are none; returns false if memory could not be allocated */
+static bool get_baked_textures(BakedTextures **out)
+{
+    GLuint names[MAX_TEXTURE_UNITS];
+    unsigned units = _ogx_textures_get_used(names);
+    *out = NULL;
+    if (!units) return true;
+
+    BakedTextures *baked = calloc(1, sizeof(BakedTextures));
+    if (!baked) return false;
+    baked->units = units;
+    for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        if (!(units & (1 << unit))) continue;
+        baked->names[unit] = names[unit];
+        _ogx_texture_get_texobj(names[unit], &baked->texobjs[unit]);
+    }
+    *out = baked;
+    return true;
+}
+
+/* Whether any of the baked textures has been re-specified, modified or
+ * deleted since the state was baked */
+static bool baked_textures_changed(const BakedTextures *baked)
+{
+    for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        if (!(baked->units & (1 << unit))) continue;
+        GXTexObj texobj;
+        if (!_ogx_texture_get_texobj(baked->names[unit], &texobj) ||
+            memcmp(&texobj, &baked->texobjs[unit], sizeof(texobj)) != 0)
+            return true;
+    }
+    return false;
+}
+
+static void free_baked_state(struct DrawGeometry *dg)
+{
+    gxlist_free(dg->state_chunk, dg->state_size);
+    dg->state_gxlist = NULL;
+    free(dg->baked_textures);
+    dg->baked_textures = NULL;
+}
+
+/* Records the GX commands setting up the current render state (except for
+ * the viewport and the scissor box) into a GX list, which will be called
+ * instead of rebuilding the state when the draw is executed. */
+static void bake_draw_state(CallList *list, struct DrawGeometry *dg)
+{
+    u32 alloc_size = STATE_GXLIST_SIZE + GXLIST_HEADROOM;
+    GXListChunk *chunk;
+    void *gxlist = gxlist_alloc(alloc_size, &chunk);
+    if (!gxlist) return;
+    DCInvalidateRange(gxlist, alloc_size);
+
+    union dirty_union dirty = glparamstate.dirty;
+    mark_baked_state_dirty();
+    glparamstate.dirty.bits.dirty_scissor = 0;
+    glparamstate.dirty.bits.dirty_viewport = 0;
+
+    _ogx_gpu_resources_push();
+    GX_BeginDispList(gxlist, alloc_size);
+    _ogx_apply_state();
+    _ogx_setup_render_stages();
+    u32 size = GX_EndDispList();
+    _ogx_gpu_resources_pop();
+
+    /* The state was only recorded, GX has not been updated */
+    glparamstate.dirty = dirty;
+    mark_baked_state_dirty();
+
+    if (size == 0 || size > STATE_GXLIST_SIZE) {
+        warning("GX state list overflow");
+        gxlist_free(chunk, alloc_size);
+        return;
+    }
+    if (!get_baked_textures(&dg->baked_textures)) {
+        gxlist_free(chunk, alloc_size);
+        return;
+    }
+    gxlist_shrink(chunk, gxlist, alloc_size, size);
+    dg->state_gxlist = gxlist;
+    dg->state_chunk = chunk;
+    dg->state_size = size;
+    list->gx_bytes += size;
+}
+
+/* Builds a GX list drawing the unique edges of the polygons of dg as
+ * GX_LINES (see glPolygonMode()), out of the vertices of its GX list */
+static void *build_edges_gxlist(struct DrawGeometry *dg, u8 mode_opcode,
+                                GXListChunk **chunk, u32 *size)
+{
+    OgxEdgeList edges;
+    if (dg->list_size < 3 + dg->count * dg->vertex_size ||
+        !_ogx_wireframe_build_edges(dg->mode, NULL, 0, 0, dg->count, &edges))
+        return NULL;
+
+    /* A GX_Begin() can draw up to 65535 vertices, an odd number */
+    const int max_vertices = 0xfffe;
+    int num_begins = (edges.count + max_vertices - 1) / max_vertices;
+    u32 list_size = ROUND_UP(num_begins * 3 + edges.count * dg->vertex_size,
+                             32);
+    u8 *gxlist = gxlist_alloc(list_size, chunk);
+    if (gxlist) {
+        const u8 *vertices = (const u8 *)dg->gxlist + 3;
+        u8 *dst = gxlist;
+        for (int i = 0; i < edges.count; i++) {
+            if (i % max_vertices == 0) {
+                int count = edges.count - i;
+                if (count > max_vertices) count = max_vertices;
+                *dst++ = mode_opcode;
+                *dst++ = count >> 8;
+                *dst++ = count & 0xff;
+            }
+            memcpy(dst, vertices + edges.indices[i] * dg->vertex_size,
+                   dg->vertex_size);
+            dst += dg->vertex_size;
+        }
+        memset(dst, GX_NOP, gxlist + list_size - dst);
+        DCStoreRange(gxlist, list_size);
+        *size = list_size;
+    }
+    _ogx_wireframe_free_edges(&edges);
+    return gxlist;
+}
+
+/* Returns the GX list drawing the geometry with the given GX_Begin() opcode,
+ * and its size. GX lists are never modified once compiled, since the GPU
+ * might still be reading them: if the drawing mode has changed (see
+ * glPolygonMode()), a copy of the list using the other primitive is made, and
+ * kept for later calls. The polygons are drawn in GL_LINE mode by a list of
+ * their edges. A polygon can be drawn in just three modes, so two copies are
+ * enough. */
+static void *gxlist_for_mode(CallList *list, struct DrawGeometry *dg,
+                             u8 mode_opcode, u32 *size)
+{
+    u8 *gxlist = dg->gxlist;
+    *size = dg->list_size;
+    if (gxlist[0] == mode_opcode) return gxlist;
+
+    int i;
+    for (i = 0; i < 2 && dg->mode_gxlists[i]; i++) {
+        gxlist = dg->mode_gxlists[i];
+        *size = dg->mode_list_sizes[i];
+        if (gxlist[0] == mode_opcode) return gxlist;
+    }
+    if (i == 2) return NULL;
+
+    if (_ogx_wireframe_is_polygon(dg->mode) &&
+        (mode_opcode & ~0x7) == GX_LINES) {
+        gxlist = build_edges_gxlist(dg, mode_opcode, &dg->mode_chunks[i],
+                                    size);
+        if (!gxlist) return NULL;
+    } else {
+        *size = dg->list_size;
+        gxlist = gxlist_alloc(dg->list_size, &dg->mode_chunks[i]);
+        if (!gxlist) return NULL;
+        memcpy(gxlist, dg->gxlist, dg->list_size);
+        /* This required peeping into GX_Begin() code. */
+        gxlist[0] = mode_opcode;
+        DCStoreRange(gxlist, dg->list_size);
+    }
+    dg->mode_gxlists[i] = gxlist;
+    dg->mode_list_sizes[i] = *size;
+    list->gx_bytes += *size;
+    debug(OGX_LOG_CALL_LISTS, "Created copy of draw list for mode %02x",
+          mode_opcode);
+    return gxlist;
 }
 
-static void run_draw_geometry(struct DrawGeometry *dg)
+static void run_draw_geometry(CallList *list, struct DrawGeometry *dg)
 {
     union client_state cs;
 
-    /* Update the drawing mode on the list. This required peeping into
-     * GX_Begin() code. */
     OgxDrawMode gxmode = _ogx_draw_mode(dg->mode);
-    u8 *fifo_ptr = dg->gxlist;
-    u8 mode_opcode = gxmode.mode | (GX_VTXFMT0 & 0x7);
-    if (*fifo_ptr != mode_opcode) {
-        /* Before altering the list, we need to make sure that it's not in use
-         * by the GP.
-         * TODO: find a better criterium, to minimize waits */
-        GX_DrawDone();
-        *fifo_ptr = mode_opcode;
-        DCStoreRange(fifo_ptr, 32); // min size is 32
+    if (glparamstate.polygon_mode == GL_LINE &&
+        _ogx_wireframe_is_polygon(dg->mode)) {
+        gxmode.mode = GX_LINES;
     }
+    u8 mode_opcode = gxmode.mode | (GX_VTXFMT0 & 0x7);
+    u32 size;
+    void *gxlist = gxlist_for_mode(list, dg, mode_opcode, &size);
+    if (!gxlist) return;
 
     _ogx_efb_set_content_type(OGX_EFB_SCENE);
 
+    /* The baked state would load the old GXTexObj, whose texels might have
+     * been freed already */
+    if (dg->baked_textures && baked_textures_changed(dg->baked_textures)) {
+        debug(OGX_LOG_CALL_LISTS, "Dropping baked state: textures changed");
+        list->gx_bytes -= dg->state_size;
+        free_baked_state(dg);
+    }
+
     _ogx_gpu_resources_push();
     cs = glparamstate.cs;
     glparamstate.cs = dg->cs;
     _ogx_update_matrices();
-    _ogx_apply_state();
-    _ogx_setup_render_stages();
+    if (dg->state_gxlist) {
+        GX_CallDispList(dg->state_gxlist, dg->state_size);
+    } else {
+        _ogx_apply_state();
+        _ogx_setup_render_stages();
+    }
     glparamstate.cs = cs;
 
-    execute_draw_geometry_list(dg);
+    execute_draw_geometry_list(dg, gxlist, size);
     _ogx_gpu_resources_pop();
+    if (dg->state_gxlist) {
+        /* The draw sampled the baked textures, not the bound ones */
+        if (dg->baked_textures) {
+            _ogx_textures_mark_in_use(dg->baked_textures->units,
+                                      dg->baked_textures->names);
+        }
+        /* The GX state no longer matches the GL state */
+        mark_baked_state_dirty();
+    } else {
+        _ogx_textures_set_in_use();
+    }
 
     glparamstate.draw_count++;
 
     if (glparamstate.stencil.enabled) {
         s_last_client_state_is_valid = false;
         _ogx_gpu_resources_push();
-        _ogx_stencil_draw(flat_draw_geometry, dg);
+        FlatDrawData data = { dg, gxlist, size };
+        _ogx_stencil_draw(flat_draw_geometry, &data);
         _ogx_gpu_resources_pop();
         s_last_client_state_is_valid = false;
     }
 }
 
-static void run_command(Command *cmd)
+static void run_command(CallList *list, Command *cmd)
 {
     switch (cmd->type) {
     case COMMAND_DRAW_ARRAYS:
-        run_draw_geometry(&cmd->c.draw_geometry);
+        run_draw_geometry(list, &cmd->c.draw_geometry);
         break;
     case COMMAND_DRAW_ELEMENTS:
-        run_draw_geometry(&cmd->c.draw_geometry);
+        run_draw_geometry(list, &cmd->c.draw_geometry);
         break;
     case COMMAND_CALL_LIST:
         glCallList(cmd->c.gllist);
@@ -433,6 +764,50 @@ static int draw_elements_index_cb(int i, void *index_data)
     return read_index(id->indices, id->type, i);
 }
 
+/* Returns the number of bytes that an attribute with the given format takes
+ * in the vertex data */
+static int attribute_data_size(const struct AttribFormat *format)
+{
+    switch (format->inputmode) {
+    case GX_NONE: return 0;
+    case GX_INDEX8: return 1;
+    case GX_INDEX16: return 2;
+    }
+
+    if (format->attribute == GX_VA_CLR0 || format->attribute == GX_VA_CLR1) {
+        switch (format->compsize) {
+        case GX_RGB565:
+        case GX_RGBA4:
+            return 2;
+        case GX_RGB8:
+        case GX_RGBA6:
+            return 3;
+        default:
+            return 4;
+        }
+    }
+
+    int num_components;
+    if (format->attribute == GX_VA_POS) {
+        num_components = format->comptype == GX_POS_XY ? 2 : 3;
+    } else if (format->attribute == GX_VA_NRM) {
+        num_components = 3;
+    } else {
+        num_components = format->comptype == GX_TEX_S ? 1 : 2;
+    }
+
+    switch (format->compsize) {
+    case GX_U8:
+    case GX_S8:
+        return num_components;
+    case GX_U16:
+    case GX_S16:
+        return num_components * 2;
+    default:
+        return num_components * 4;
+    }
+}
+
 static void queue_draw_geometry(struct DrawGeometry *dg,
                                 GLenum mode, GLsizei count,
                                 IndexCallback index_cb,
@@ -446,10 +821,16 @@ static void queue_draw_geometry(struct DrawGeometry *dg,
      * attributes: this will allow us to set the value of the indexed attribute
      * at the time when the list is executed. */
     dg->mode = mode;
-    dg->gxlist = memalign(32, MAX_GXLIST_SIZE);
-    DCInvalidateRange(dg->gxlist, MAX_GXLIST_SIZE);
+    dg->gxlist = NULL;
+    dg->list_size = 0;
     dg->cs = glparamstate.cs;
+    /* The list is compiled with the primitive of the GL_FILL mode, whatever
+     * the current polygon mode: the others get their own copy of the list
+     * when run (see gxlist_for_mode()) */
+    GLenum polygon_mode = glparamstate.polygon_mode;
+    glparamstate.polygon_mode = GL_FILL;
     OgxDrawMode gxmode = _ogx_draw_mode(mode);
+    glparamstate.polygon_mode = polygon_mode;
     dg->count = count + gxmode.loop;
 
     if (glparamstate.dirty.bits.dirty_attributes)
@@ -463,33 +844,51 @@ static void queue_draw_geometry(struct DrawGeometry *dg,
     /* Get the GX formats used right now */
     OgxArrayReader *reader = NULL;
     int format_index = 0;
+    int vertex_size = 0;
     memset(dg->formats, 0, sizeof(dg->formats));
     while (reader = _ogx_array_reader_next(reader)) {
-        uint8_t attribute, inputmode, size, type;
+        uint8_t attribute, inputmode, size, type, frac;
         _ogx_array_reader_get_format(reader, &attribute, &inputmode,
-                                     &type, &size);
+                                     &type, &size, &frac);
         dg->formats[format_index].attribute = attribute;
         dg->formats[format_index].inputmode = inputmode;
         dg->formats[format_index].comptype = type;
         dg->formats[format_index].compsize = size;
+        dg->formats[format_index].frac = frac;
+        int data_size = attribute_data_size(&dg->formats[format_index]);
         format_index++;
 
         if (attribute == GX_VA_POS) {
             vertex_reader = reader;
+            vertex_size += data_size;
         } else if (attribute == GX_VA_NRM) {
             normal_reader = reader;
+            vertex_size += data_size;
         } else if (attribute == GX_VA_CLR0) {
             /* Ignore CLR1, since, if present, it's identical */
             color_reader = reader;
+            vertex_size += data_size * 2;
         } else if (attribute >= GX_VA_TEX0 &&
                    attribute < GX_VA_TEX0 + MAX_TEXTURE_UNITS) {
             texcoord_reader[attribute - GX_VA_TEX0] = reader;
+            vertex_size += data_size;
         }
     }
+    /* Indexes for the current normal and colors */
+    if (!normal_reader) vertex_size += 1;
+    if (!color_reader) vertex_size += 2;
+
+    dg->vertex_size = vertex_size;
 
-    GX_BeginDispList(dg->gxlist, MAX_GXLIST_SIZE);
+    /* GX_Begin() takes 3 bytes */
+    u32 expected_size = ROUND_UP(3 + dg->count * vertex_size, 32);
+    u32 alloc_size = expected_size + GXLIST_HEADROOM;
+    GXListChunk *chunk;
+    void *gxlist = gxlist_alloc(alloc_size, &chunk);
+    if (!gxlist) return;
+    DCInvalidateRange(gxlist, alloc_size);
 
-    /* Note that the drawing mode set here will be overwritten when executing the list */
+    GX_BeginDispList(gxlist, alloc_size);
 
     GX_Begin(gxmode.mode, GX_VTXFMT0, dg->count);
     for (int i = 0; i < dg->count; i++) {
@@ -521,11 +920,23 @@ static void queue_draw_geometry(struct DrawGeometry *dg,
     GX_End();
 
     u32 size = GX_EndDispList();
-    fprintf(stderr, "Created draw list %u\n", size);
-    /* Free any excess memory */
-    void *new_ptr = realloc(dg->gxlist, size);
-    assert(new_ptr == dg->gxlist);
+    if (size == 0 || size > expected_size) {
+        warning("GX list overflow (expected %u bytes)", expected_size);
+        gxlist_free(chunk, alloc_size);
+        return;
+    }
+    gxlist_shrink(chunk, gxlist, alloc_size, size);
+    debug(OGX_LOG_CALL_LISTS, "Created draw list %u", size);
+    dg->gxlist = gxlist;
+    dg->chunk = chunk;
     dg->list_size = size;
+    call_lists[glparamstate.current_call_list.index].gx_bytes += size;
+
+    /* In GL_COMPILE mode, the state is baked by glEndList() */
+    if ((glparamstate.hints & OGX_HINT_BAKE_CALL_LISTS) &&
+        glparamstate.current_call_list.must_execute) {
+        bake_draw_state(&call_lists[glparamstate.current_call_list.index], dg);
+    }
 }
 
 static void queue_draw_arrays(struct DrawGeometry *dg,
@@ -544,23 +955,105 @@ static void queue_draw_elements(struct DrawGeometry *dg,
                         draw_elements_index_cb, &id);
 }
 
-static void destroy_buffer(CommandBuffer *buffer)
+/* Frees the GX lists owned by the given commands; returns their size */
+static u32 free_gxlists(Command *commands, u32 count)
 {
-    if (buffer->next) {
-        destroy_buffer(buffer->next);
+    u32 bytes = 0;
+    for (u32 i = 0; i < count; i++) {
+        Command *command = &commands[i];
+
+        /* Free the memory for those commands who allocated it */
+        if ((command->type == COMMAND_DRAW_ELEMENTS ||
+             command->type == COMMAND_DRAW_ARRAYS) &&
+            command->c.draw_geometry.gxlist) {
+            struct DrawGeometry *dg = &command->c.draw_geometry;
+            gxlist_free(dg->chunk, dg->list_size);
+            bytes += dg->list_size;
+            for (int m = 0; m < 2 && dg->mode_gxlists[m]; m++) {
+                gxlist_free(dg->mode_chunks[m], dg->mode_list_sizes[m]);
+                bytes += dg->mode_list_sizes[m];
+            }
+            if (dg->state_gxlist) {
+                bytes += dg->state_size;
+                free_baked_state(dg);
+            }
+        }
     }
+    return bytes;
+}
 
-    for (int i =0; i < MAX_COMMANDS_PER_BUFFER; i++) {
-        Command *command = &buffer->commands[i];
-        if (command->type == COMMAND_NONE) break;
+/* Returns true if none of the commands changes the vertex setup cached in
+ * s_last_client_state and s_last_formats, so that the draws of the next list
+ * called by glCallLists() can still rely on it. */
+static bool keeps_vertex_setup(const Command *commands, u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        switch (commands[i].type) {
+        case COMMAND_NONE:
+        case COMMAND_DRAW_ARRAYS:
+        case COMMAND_DRAW_ELEMENTS:
+        case COMMAND_ENABLE:
+        case COMMAND_DISABLE:
+        case COMMAND_LIGHT:
+        case COMMAND_MATERIAL:
+        case COMMAND_BLEND_FUNC:
+        case COMMAND_BIND_TEXTURE:
+        case COMMAND_TEX_ENV:
+        case COMMAND_LOAD_IDENTITY:
+        case COMMAND_PUSH_MATRIX:
+        case COMMAND_POP_MATRIX:
+        case COMMAND_MULT_MATRIX:
+        case COMMAND_TRANSLATE:
+        case COMMAND_ROTATE:
+        case COMMAND_SCALE:
+        case COMMAND_FRONT_FACE:
+        case COMMAND_COLOR:
+        case COMMAND_NORMAL:
+            break;
+        default:
+            /* Including COMMAND_CALL_LIST, since the called list can be
+             * redefined at any time */
+            return false;
+        }
+    }
+    return true;
+}
 
-        /* Free the memory for those commands who allocated it */
-        if (command->type == COMMAND_DRAW_ELEMENTS ||
-            command->type == COMMAND_DRAW_ARRAYS) {
-            free(command->c.draw_geometry.gxlist);
+static void drop_flat_commands(CallList *list)
+{
+    if (list->flat_commands) {
+        list->gx_bytes -= free_gxlists(list->flat_commands,
+                                       list->num_flat_commands);
+        free(list->flat_commands);
+        list->flat_commands = NULL;
+        list->num_flat_commands = 0;
+        s_num_flat_lists--;
+        list->keeps_vertex_setup =
+            keeps_vertex_setup(list->commands, list->num_commands);
+    }
+    free(list->inlined);
+    list->inlined = NULL;
+    list->num_inlined = 0;
+}
+
+/* Drops the flattened commands which contain a copy of the given list; they
+ * will be rebuilt when their list is called again. */
+static void invalidate_callers(int index)
+{
+    for (int i = 0; i < MAX_CALL_LISTS && s_num_flat_lists > 0; i++) {
+        CallList *list = &call_lists[i];
+        if (!list->flat_commands) continue;
+
+        for (u32 j = 0; j < list->num_inlined; j++) {
+            if (list->inlined[j] == index) {
+                debug(OGX_LOG_CALL_LISTS, "List %d changed, unflattening %d",
+                      index, i);
+                drop_flat_commands(list);
+                list->must_flatten = true;
+                break;
+            }
         }
     }
-    free(buffer);
 }
 
 static void destroy_list(int index)
@@ -568,10 +1061,536 @@ static void destroy_list(int index)
     CallList *list = &call_lists[index];
     if (!LIST_IS_RESERVED_OR_USED(index)) return;
 
-    if (BUFFER_IS_VALID(list->head)) {
-        destroy_buffer(list->head);
+    drop_flat_commands(list);
+    list->must_flatten = false;
+    if (COMMANDS_ARE_VALID(list->commands)) {
+        free_gxlists(list->commands, list->num_commands);
+        free(list->commands);
+        invalidate_callers(index);
+    }
+    LIST_UNRESERVE(index);
+    list->num_commands = 0;
+    list->capacity = 0;
+    list->gx_bytes = 0;
+    list->keeps_vertex_setup = false;
+}
+
+/* Optimizations run when the list is complete. Each pass compacts the command
+ * array in place, and returns the new number of commands. */
+
+static bool is_affine(const GLfloat *m)
+{
+    return m[3] == 0.0f && m[7] == 0.0f && m[11] == 0.0f && m[15] == 1.0f;
+}
+
+static bool is_matrix_command(const Command *cmd)
+{
+    switch (cmd->type) {
+    case COMMAND_LOAD_IDENTITY:
+    case COMMAND_TRANSLATE:
+    case COMMAND_ROTATE:
+    case COMMAND_SCALE:
+        return true;
+    case COMMAND_MULT_MATRIX:
+        /* glMultMatrixf() handles the others in a special way */
+        return is_affine(cmd->c.matrix);
+    default:
+        return false;
     }
-    list->head = NULL;
+}
+
+/* Writes the matrix multiplied by the given command, in GL order */
+static void command_matrix(const Command *cmd, GLfloat *m)
+{
+    static const GLfloat identity[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f,
+    };
+    floatcpy(m, identity, 16);
+
+    switch (cmd->type) {
+    case COMMAND_TRANSLATE:
+        m[12] = cmd->c.xyz.x;
+        m[13] = cmd->c.xyz.y;
+        m[14] = cmd->c.xyz.z;
+        break;
+    case COMMAND_SCALE:
+        m[0] = cmd->c.xyz.x;
+        m[5] = cmd->c.xyz.y;
+        m[10] = cmd->c.xyz.z;
+        break;
+    case COMMAND_ROTATE:
+        {
+            float x = cmd->c.rotate.x, y = cmd->c.rotate.y,
+                  z = cmd->c.rotate.z;
+            float len = sqrtf(x * x + y * y + z * z);
+            /* glRotatef() ignores these */
+            if (cmd->c.rotate.angle == 0.0f || len == 0.0f) break;
+            x /= len; y /= len; z /= len;
+            float angle = cmd->c.rotate.angle * M_PI / 180.0f;
+            float c = cosf(angle), s = sinf(angle), t = 1.0f - c;
+            m[0] = x * x * t + c;
+            m[1] = y * x * t + z * s;
+            m[2] = x * z * t - y * s;
+            m[4] = x * y * t - z * s;
+            m[5] = y * y * t + c;
+            m[6] = y * z * t + x * s;
+            m[8] = x * z * t + y * s;
+            m[9] = y * z * t - x * s;
+            m[10] = z * z * t + c;
+        }
+        break;
+    case COMMAND_MULT_MATRIX:
+        floatcpy(m, cmd->c.matrix, 16);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Replaces each sequence of matrix operations with a single glMultMatrix(),
+ * preceded by glLoadIdentity() if the sequence contains it. */
+static u32 fold_matrix_commands(Command *commands, u32 count)
+{
+    u32 out = 0;
+    for (u32 i = 0; i < count; ) {
+        u32 end = i;
+        while (end < count && is_matrix_command(&commands[end])) end++;
+        if (end - i < 2) {
+            commands[out++] = commands[i++];
+            continue;
+        }
+
+        /* Whatever precedes the last glLoadIdentity() has no effect */
+        u32 start = end;
+        while (start > i &&
+               commands[start - 1].type != COMMAND_LOAD_IDENTITY) start--;
+        bool load_identity = start > i;
+        u32 num_products = end - start;
+        if (load_identity + (num_products > 0) < end - i) {
+            Command folded;
+            memset(&folded, 0, sizeof(folded));
+            if (num_products == 1) {
+                folded = commands[start];
+            } else if (num_products > 1) {
+                GLfloat product[16], m[16], tmp[16];
+                command_matrix(&commands[start], product);
+                for (u32 j = start + 1; j < end; j++) {
+                    command_matrix(&commands[j], m);
+                    gl_matrix_multiply(tmp, product, m);
+                    floatcpy(product, tmp, 16);
+                }
+                folded.type = COMMAND_MULT_MATRIX;
+                floatcpy(folded.c.matrix, product, 16);
+            }
+            if (load_identity) {
+                memset(&commands[out], 0, sizeof(Command));
+                commands[out++].type = COMMAND_LOAD_IDENTITY;
+            }
+            if (num_products > 0) commands[out++] = folded;
+        } else {
+            for (u32 j = i; j < end; j++) commands[out++] = commands[j];
+        }
+        i = end;
+    }
+    return out;
+}
+
+/* Identifies the piece of state set by a command: commands with the same
+ * kind and key override each other */
+typedef struct {
+    CommandType kind;
+    u32 key;
+    const Command *last; /* last command which set this state */
+} StateEntry;
+
+#define MAX_TRACKED_STATES 32
+
+static bool command_state_key(const Command *cmd, StateEntry *entry)
+{
+    entry->kind = cmd->type;
+    entry->key = 0;
+    switch (cmd->type) {
+    case COMMAND_ENABLE:
+    case COMMAND_DISABLE:
+        entry->kind = COMMAND_ENABLE;
+        entry->key = cmd->c.cap;
+        return true;
+    case COMMAND_LIGHT:
+        /* The position and direction depend on the modelview matrix */
+        if (cmd->c.light.pname == GL_POSITION ||
+            cmd->c.light.pname == GL_SPOT_DIRECTION) return false;
+        entry->key = (cmd->c.light.light << 16) | cmd->c.light.pname;
+        return true;
+    case COMMAND_MATERIAL:
+        entry->key = (cmd->c.material.face << 16) | cmd->c.material.pname;
+        return true;
+    case COMMAND_BIND_TEXTURE:
+        entry->key = cmd->c.bound_texture.target;
+        return true;
+    case COMMAND_TEX_ENV:
+        entry->key = (cmd->c.tex_env.target << 16) | cmd->c.tex_env.pname;
+        return true;
+    case COMMAND_BLEND_FUNC:
+    case COMMAND_FRONT_FACE:
+    case COMMAND_COLOR:
+    case COMMAND_NORMAL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int find_state(const StateEntry *states, int num_states,
+                      const StateEntry *entry)
+{
+    for (int i = 0; i < num_states; i++) {
+        if (states[i].kind == entry->kind && states[i].key == entry->key)
+            return i;
+    }
+    return -1;
+}
+
+static void forget_states(StateEntry *states, int *num_states,
+                          CommandType kind)
+{
+    int n = 0;
+    for (int i = 0; i < *num_states; i++) {
+        if (states[i].kind != kind) states[n++] = states[i];
+    }
+    *num_states = n;
+}
+
+/* Whether two glMaterial() commands set some common piece of state, possibly
+ * under different names (like GL_FRONT and GL_FRONT_AND_BACK) */
+static bool materials_overlap(const Command *a, const Command *b)
+{
+    GLenum face_a = a->c.material.face, face_b = b->c.material.face;
+    GLenum pname_a = a->c.material.pname, pname_b = b->c.material.pname;
+    bool faces = face_a == face_b ||
+        face_a == GL_FRONT_AND_BACK || face_b == GL_FRONT_AND_BACK;
+    bool pnames = pname_a == pname_b ||
+        (pname_a == GL_AMBIENT_AND_DIFFUSE &&
+         (pname_b == GL_AMBIENT || pname_b == GL_DIFFUSE)) ||
+        (pname_b == GL_AMBIENT_AND_DIFFUSE &&
+         (pname_a == GL_AMBIENT || pname_a == GL_DIFFUSE));
+    return faces && pnames;
+}
+
+/* Forgets the materials set under a different name than the one of cmd, but
+ * overwritten by it */
+static void forget_overlapping_materials(StateEntry *states, int *num_states,
+                                         const Command *cmd,
+                                         const StateEntry *entry)
+{
+    int n = 0;
+    for (int i = 0; i < *num_states; i++) {
+        if (states[i].kind == COMMAND_MATERIAL &&
+            states[i].key != entry->key &&
+            materials_overlap(states[i].last, cmd)) continue;
+        states[n++] = states[i];
+    }
+    *num_states = n;
+}
+
+/* Drops the state changes which set the same value that the list itself set
+ * earlier, and the glPushMatrix() immediately followed by glPopMatrix() */
+static u32 drop_redundant_commands(Command *commands, u32 count)
+{
+    StateEntry states[MAX_TRACKED_STATES];
+    int num_states = 0;
+    u32 out = 0;
+    for (u32 i = 0; i < count; i++) {
+        Command *cmd = &commands[i];
+        StateEntry entry;
+        if (command_state_key(cmd, &entry)) {
+            int s = find_state(states, num_states, &entry);
+            if (s >= 0) {
+                const Command *last = states[s].last;
+                if (last->type == cmd->type &&
+                    memcmp(&last->c, &cmd->c, sizeof(cmd->c)) == 0) continue;
+            }
+
+            /* The current color might change the material */
+            if (cmd->type == COMMAND_COLOR ||
+                (entry.kind == COMMAND_ENABLE &&
+                 entry.key == GL_COLOR_MATERIAL)) {
+                forget_states(states, &num_states, COMMAND_MATERIAL);
+                s = find_state(states, num_states, &entry);
+            } else if (cmd->type == COMMAND_MATERIAL) {
+                forget_overlapping_materials(states, &num_states, cmd, &entry);
+                s = find_state(states, num_states, &entry);
+            }
+            if (s < 0 && num_states < MAX_TRACKED_STATES) s = num_states++;
+
+            commands[out] = *cmd;
+            if (s >= 0) {
+                states[s] = entry;
+                states[s].last = &commands[out];
+            }
+            out++;
+        } else if (cmd->type == COMMAND_POP_MATRIX && out > 0 &&
+                   commands[out - 1].type == COMMAND_PUSH_MATRIX) {
+            out--;
+        } else {
+            /* A called list can change any state */
+            if (cmd->type == COMMAND_CALL_LIST) num_states = 0;
+            commands[out++] = *cmd;
+        }
+    }
+    return out;
+}
+
+static bool is_draw_command(const Command *cmd)
+{
+    return (cmd->type == COMMAND_DRAW_ARRAYS ||
+            cmd->type == COMMAND_DRAW_ELEMENTS) &&
+        cmd->c.draw_geometry.gxlist != NULL;
+}
+
+static bool can_merge_draws(const struct DrawGeometry *a,
+                            const struct DrawGeometry *b)
+{
+    /* Only independent primitives can be joined into a single one, and the
+     * vertices of b must not complete an incomplete primitive of a */
+    int primitive_size;
+    switch (a->mode) {
+    case GL_POINTS: primitive_size = 1; break;
+    case GL_LINES: primitive_size = 2; break;
+    case GL_TRIANGLES: primitive_size = 3; break;
+    case GL_QUADS: primitive_size = 4; break;
+    default:
+        return false;
+    }
+    return a->mode == b->mode && a->count % primitive_size == 0 &&
+        a->cs.as_int == b->cs.as_int &&
+        /* Copies for other modes are only made while running the list */
+        !a->mode_gxlists[0] && !b->mode_gxlists[0] &&
+        a->vertex_size == b->vertex_size &&
+        a->list_size >= 3 + a->count * a->vertex_size &&
+        b->list_size >= 3 + b->count * b->vertex_size &&
+        /* The baked state, if any, must be the same */
+        a->state_size == b->state_size &&
+        (a->state_size == 0 ||
+         memcmp(a->state_gxlist, b->state_gxlist, a->state_size) == 0) &&
+        memcmp(a->formats, b->formats, sizeof(a->formats)) == 0 &&
+        a->count + b->count <= 0xffff;
+}
+
+/* Joins the vertices of b into a single GX primitive with those of a */
+static bool merge_draws(CallList *list, struct DrawGeometry *a,
+                        struct DrawGeometry *b)
+{
+    u32 count = a->count + b->count;
+    u32 a_bytes = a->count * a->vertex_size;
+    u32 b_bytes = b->count * b->vertex_size;
+    u32 size = ROUND_UP(3 + a_bytes + b_bytes, 32);
+    GXListChunk *chunk;
+    u8 *gxlist = gxlist_alloc(size, &chunk);
+    if (!gxlist) return false;
+
+    /* Reuse the GX_Begin() opcode, and update the vertex count */
+    const u8 *a_data = a->gxlist;
+    const u8 *b_data = b->gxlist;
+    gxlist[0] = a_data[0];
+    gxlist[1] = count >> 8;
+    gxlist[2] = count & 0xff;
+    memcpy(gxlist + 3, a_data + 3, a_bytes);
+    memcpy(gxlist + 3 + a_bytes, b_data + 3, b_bytes);
+    memset(gxlist + 3 + a_bytes + b_bytes, GX_NOP,
+           size - 3 - a_bytes - b_bytes);
+    DCStoreRange(gxlist, size);
+
+    list->gx_bytes += size - a->list_size - b->list_size;
+    gxlist_free(a->chunk, a->list_size);
+    gxlist_free(b->chunk, b->list_size);
+    if (b->state_gxlist) {
+        list->gx_bytes -= b->state_size;
+        free_baked_state(b);
+    }
+    a->gxlist = gxlist;
+    a->chunk = chunk;
+    a->list_size = size;
+    a->count = count;
+    return true;
+}
+
+/* Concatenates the adjacent draws which are executed with the same state */
+static u32 merge_draw_commands(CallList *list, Command *commands, u32 count)
+{
+    u32 out = 0;
+    for (u32 i = 0; i < count; i++) {
+        Command *cmd = &commands[i];
+        if (out > 0 && is_draw_command(cmd) &&
+            is_draw_command(&commands[out - 1])) {
+            struct DrawGeometry *last = &commands[out - 1].c.draw_geometry;
+            if (can_merge_draws(last, &cmd->c.draw_geometry) &&
+                merge_draws(list, last, &cmd->c.draw_geometry)) continue;
+        }
+        commands[out++] = *cmd;
+    }
+    return out;
+}
+
+static void optimize_list(CallList *list)
+{
+    u32 count = list->num_commands;
+    count = fold_matrix_commands(list->commands, count);
+    count = drop_redundant_commands(list->commands, count);
+    count = merge_draw_commands(list, list->commands, count);
+    debug(OGX_LOG_CALL_LISTS, "Optimized list: %u commands, down from %u",
+          count, list->num_commands);
+    list->num_commands = count;
+}
+
+/* Flattening (see OGX_HINT_INLINE_CALL_LISTS): the commands of the lists
+ * called by a list, and of the lists called by those, are copied into its
+ * flat_commands array, together with their GX lists. The list keeps track of
+ * the inlined lists, so that their redefinition or deletion can invalidate the
+ * copy. */
+
+static bool can_inline(GLuint gllist, const int *stack, int depth)
+{
+    if (gllist < CALL_LIST_START_ID ||
+        gllist - CALL_LIST_START_ID >= MAX_CALL_LISTS ||
+        depth >= MAX_INLINE_DEPTH) return false;
+
+    int index = gllist - CALL_LIST_START_ID;
+    /* The list being compiled is not complete yet */
+    if (!LIST_IS_USED(index) ||
+        index == glparamstate.current_call_list.index) return false;
+    /* Recursive calls are left alone */
+    for (int i = 0; i < depth; i++) {
+        if (stack[i] == index) return false;
+    }
+    return true;
+}
+
+static bool add_inlined(CallList *list, int index)
+{
+    for (u32 i = 0; i < list->num_inlined; i++) {
+        if (list->inlined[i] == index) return true;
+    }
+    u16 *inlined = realloc(list->inlined,
+                           (list->num_inlined + 1) * sizeof(u16));
+    if (!inlined) return false;
+    inlined[list->num_inlined++] = index;
+    list->inlined = inlined;
+    return true;
+}
+
+static void *copy_gxlist(CallList *list, const void *src, u32 size,
+                         GXListChunk **chunk)
+{
+    void *gxlist = gxlist_alloc(size, chunk);
+    if (!gxlist) return NULL;
+    memcpy(gxlist, src, size);
+    DCStoreRange(gxlist, size);
+    list->gx_bytes += size;
+    return gxlist;
+}
+
+/* Gives the copy of a draw command its own GX lists */
+static bool copy_draw_geometry(CallList *list, struct DrawGeometry *dg)
+{
+    memset(dg->mode_gxlists, 0, sizeof(dg->mode_gxlists));
+    void *state_gxlist = dg->state_gxlist;
+    const BakedTextures *baked_textures = dg->baked_textures;
+    dg->state_gxlist = NULL;
+    dg->baked_textures = NULL;
+    dg->gxlist = copy_gxlist(list, dg->gxlist, dg->list_size, &dg->chunk);
+    if (!dg->gxlist) return false;
+    if (state_gxlist) {
+        dg->state_gxlist = copy_gxlist(list, state_gxlist, dg->state_size,
+                                       &dg->state_chunk);
+        if (!dg->state_gxlist) {
+            gxlist_free(dg->chunk, dg->list_size);
+            list->gx_bytes -= dg->list_size;
+            return false;
+        }
+        if (baked_textures) {
+            dg->baked_textures = malloc(sizeof(BakedTextures));
+            if (!dg->baked_textures) {
+                /* Rather than sampling untracked textures, don't bake */
+                list->gx_bytes -= dg->state_size;
+                free_baked_state(dg);
+            } else {
+                *dg->baked_textures = *baked_textures;
+            }
+        }
+    }
+    return true;
+}
+
+/* Appends the commands of the list stack[depth - 1] to flat */
+static bool inline_commands(CallList *list, CallList *flat,
+                            int *stack, int depth)
+{
+    const CallList *source = &call_lists[stack[depth - 1]];
+    for (u32 i = 0; i < source->num_commands; i++) {
+        const Command *cmd = &source->commands[i];
+        if (cmd->type == COMMAND_CALL_LIST &&
+            can_inline(cmd->c.gllist, stack, depth)) {
+            stack[depth] = cmd->c.gllist - CALL_LIST_START_ID;
+            if (!add_inlined(list, stack[depth]) ||
+                !inline_commands(list, flat, stack, depth + 1)) return false;
+            continue;
+        }
+
+        Command *copy = new_command(flat);
+        if (!copy) return false;
+        *copy = *cmd;
+        if (is_draw_command(copy) &&
+            !copy_draw_geometry(list, &copy->c.draw_geometry)) {
+            /* Make sure that the borrowed GX lists won't be freed */
+            flat->num_commands--;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void flatten_list(int index)
+{
+    CallList *list = &call_lists[index];
+    int stack[MAX_INLINE_DEPTH];
+
+    list->must_flatten = false;
+    stack[0] = index;
+    bool has_calls = false;
+    for (u32 i = 0; i < list->num_commands && !has_calls; i++) {
+        const Command *cmd = &list->commands[i];
+        has_calls = cmd->type == COMMAND_CALL_LIST &&
+            can_inline(cmd->c.gllist, stack, 1);
+    }
+    if (!has_calls) return;
+
+    CallList flat = { NULL, 0, 0, 0 };
+    u32 gx_bytes = list->gx_bytes;
+    if (!inline_commands(list, &flat, stack, 1)) {
+        warning("Failed to flatten call list %d", index);
+        if (COMMANDS_ARE_VALID(flat.commands)) {
+            free_gxlists(flat.commands, flat.num_commands);
+            free(flat.commands);
+        }
+        list->gx_bytes = gx_bytes;
+        drop_flat_commands(list);
+        return;
+    }
+
+    /* The inlined commands can now be optimized together with the caller's */
+    u32 count = flat.num_commands;
+    count = fold_matrix_commands(flat.commands, count);
+    count = drop_redundant_commands(flat.commands, count);
+    count = merge_draw_commands(list, flat.commands, count);
+    debug(OGX_LOG_CALL_LISTS, "Flattened list %d: %u commands, %u inlined",
+          index, count, list->num_inlined);
+    list->flat_commands = flat.commands;
+    list->num_flat_commands = count;
+    list->keeps_vertex_setup = keeps_vertex_setup(flat.commands, count);
+    s_num_flat_lists++;
 }
 
 /* This function returns true if the caller's code needs to be executed now,
@@ -584,7 +1603,6 @@ static void destroy_list(int index)
 bool _ogx_call_list_append(CommandType op, ...)
 {
     CallList *list = &call_lists[glparamstate.current_call_list.index];
-    CommandBuffer *buffer = list->head;
     Command *command;
     va_list ap;
     int count;
@@ -592,7 +1610,9 @@ bool _ogx_call_list_append(CommandType op, ...)
     debug(OGX_LOG_CALL_LISTS, "Adding command %d to list %d",
           op, glparamstate.current_call_list.index);
 
-    command = new_command(&list->head);
+    command = new_command(list);
+    if (!command) return glparamstate.current_call_list.must_execute;
+
     command->type = op;
     va_start(ap, op);
     switch (op) {
@@ -727,7 +1747,7 @@ void glDeleteLists(GLuint list, GLsizei range)
     }
 
     for (int i = 0; i < range; i++) {
-        int index = list - CALL_LIST_START_ID;
+        int index = list + i - CALL_LIST_START_ID;
         if (index < 0 || index >= MAX_CALL_LISTS) {
             /* Note that OpenGL does not specify an error in this case */
             break;
@@ -739,29 +1759,21 @@ void glDeleteLists(GLuint list, GLsizei range)
 
 GLuint glGenLists(GLsizei range)
 {
-    int remaining = range;
-
-    for (int i = 0; i < MAX_CALL_LISTS && remaining > 0; i++) {
-        if (!LIST_IS_RESERVED_OR_USED(i)) {
-            remaining--;
-            if (remaining == 0) {
-                /* We found a contiguous range available. Reserve them*/
-                int first = i - range + 1;
-                for (int j = first; j < first + range; j++)
-                    LIST_RESERVE(j);
-                return first + CALL_LIST_START_ID;
-            }
-        } else {
-            remaining = range;
-        }
+    if (range <= 0) {
+        if (range < 0) set_error(GL_INVALID_VALUE);
+        return 0;
     }
 
-    if (remaining > 0) {
-        warning("Could not allocate %d display lists", remaining);
+    int first = _ogx_id_alloc(&s_list_ids, range);
+    if (first < 0) {
+        warning("Could not allocate %d display lists", range);
         set_error(GL_OUT_OF_MEMORY);
+        return 0;
     }
 
-    return 0;
+    for (int i = first; i < first + range; i++)
+        LIST_RESERVE(i);
+    return first + CALL_LIST_START_ID;
 }
 
 void glNewList(GLuint list, GLenum mode)
@@ -791,6 +1803,36 @@ void glNewList(GLuint list, GLenum mode)
     LIST_RESERVE(list);
 }
 
+/* Bakes the render state of the draws of a list compiled in GL_COMPILE mode
+ * (see bake_draw_state()). Its state commands were only recorded, so they are
+ * applied, in order, to a copy of the current GL state. */
+static void bake_list_state(CallList *list)
+{
+    glparams_ *saved = malloc(sizeof(glparams_));
+    if (!saved) return;
+    memcpy(saved, &glparamstate, sizeof(glparams_));
+
+    for (u32 i = 0; i < list->num_commands; i++) {
+        Command *cmd = &list->commands[i];
+        if (is_draw_command(cmd)) {
+            if (cmd->c.draw_geometry.gxlist)
+                bake_draw_state(list, &cmd->c.draw_geometry);
+        } else if (cmd->type == COMMAND_CALL_LIST) {
+            /* The state set by the called list is only known when it runs,
+             * so the draws from here on are not baked */
+            break;
+        } else {
+            run_command(list, cmd);
+        }
+    }
+
+    /* The texture names bound by the list stay reserved */
+    memcpy(saved->textures, glparamstate.textures, sizeof(saved->textures));
+    memcpy(&glparamstate, saved, sizeof(glparams_));
+    free(saved);
+    mark_baked_state_dirty();
+}
+
 void glEndList(void)
 {
     if (glparamstate.current_call_list.index < 0) {
@@ -798,9 +1840,36 @@ void glEndList(void)
         return;
     }
 
-    GLuint list = glparamstate.current_call_list.index + CALL_LIST_START_ID;
+    int index = glparamstate.current_call_list.index;
+    CallList *list = &call_lists[index];
+    if (COMMANDS_ARE_VALID(list->commands)) optimize_list(list);
+    if (COMMANDS_ARE_VALID(list->commands) && list->num_commands > 0 &&
+        list->num_commands < list->capacity) {
+        /* Release the unused tail of the command array */
+        Command *commands =
+            realloc(list->commands, list->num_commands * sizeof(Command));
+        if (commands) {
+            list->commands = commands;
+            list->capacity = list->num_commands;
+        }
+    }
+
     glparamstate.current_call_list.index = -1;
     glparamstate.current_call_list.execution_depth = 0;
+
+    if (COMMANDS_ARE_VALID(list->commands) &&
+        (glparamstate.hints & OGX_HINT_BAKE_CALL_LISTS) &&
+        !glparamstate.current_call_list.must_execute) {
+        bake_list_state(list);
+    }
+    if (COMMANDS_ARE_VALID(list->commands)) {
+        list->keeps_vertex_setup =
+            keeps_vertex_setup(list->commands, list->num_commands);
+    }
+    if (COMMANDS_ARE_VALID(list->commands) &&
+        (glparamstate.hints & OGX_HINT_INLINE_CALL_LISTS)) {
+        flatten_list(index);
+    }
 }
 
 void glCallList(GLuint id)
@@ -813,6 +1882,8 @@ void glCallList(GLuint id)
 
     HANDLE_CALL_LIST(CALL_LIST, id);
 
+    _ogx_flush_draw_batch();
+
     debug(OGX_LOG_CALL_LISTS, "Calling list %d", id - CALL_LIST_START_ID);
 
     bool must_decrement = false;
@@ -823,29 +1894,46 @@ void glCallList(GLuint id)
         must_decrement = true;
     }
 
-    CallList *list = &call_lists[id - CALL_LIST_START_ID];
-    for (CommandBuffer *buffer = list->head;
-         BUFFER_IS_VALID(buffer);
-         buffer = buffer->next) {
-        for (int i =0; i < MAX_COMMANDS_PER_BUFFER; i++) {
-            Command *command = &buffer->commands[i];
-            if (command->type == COMMAND_NONE) goto done;
-
-            run_command(command);
+    int index = id - CALL_LIST_START_ID;
+    CallList *list = &call_lists[index];
+    if (LIST_IS_USED(index)) {
+        if (list->must_flatten) flatten_list(index);
+        Command *commands = list->commands;
+        u32 num_commands = list->num_commands;
+        if (list->flat_commands) {
+            commands = list->flat_commands;
+            num_commands = list->num_flat_commands;
+        }
+        for (u32 i = 0; i < num_commands; i++) {
+            run_command(list, &commands[i]);
         }
     }
 
-done:
     /* Until we find a reliable mechanism to ensure that the client state has
-     * been preserved, avoid reusing it across different lists. */
-    s_last_client_state_is_valid = false;
+     * been preserved, avoid reusing it across different lists. The only
+     * exception are the lists run by glCallLists(), since no other code can
+     * run in between. */
+    if (!s_calling_lists || !list->keeps_vertex_setup) {
+        s_last_client_state_is_valid = false;
+    }
 
     if (must_decrement) {
         glparamstate.current_call_list.execution_depth--;
     }
 }
 
+uint32_t ogx_call_list_gx_bytes(GLuint list)
+{
+    if (list < CALL_LIST_START_ID ||
+        list - CALL_LIST_START_ID >= MAX_CALL_LISTS) return 0;
+
+    return call_lists[list - CALL_LIST_START_ID].gx_bytes;
+}
+
 void glCallLists(GLsizei n, GLenum type, const GLvoid *lists)
 {
+    s_calling_lists = glparamstate.current_call_list.index < 0;
     foreach(n, type, lists, glCallList);
+    s_calling_lists = false;
+    s_last_client_state_is_valid = false;
 }
@@ -43,8 +43,7 @@ extern "C" {
  * (e.g., COMMAND_ENABLE == glEnable)
  */
 typedef enum {
-    COMMAND_NONE, /* The command entry is unused, it means we reached the end
-                     of the call list */
+    COMMAND_NONE, /* The command entry is unused */
     COMMAND_DRAW_ARRAYS,
     COMMAND_DRAW_ELEMENTS,
     COMMAND_CALL_LIST,
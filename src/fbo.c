@@ -236,6 +236,7 @@ GLboolean glIsFramebuffer(GLuint framebuffer)
 
 void glBindFramebuffer(GLenum target, GLuint framebuffer)
 {
+    _ogx_flush_draw_batch();
     if (framebuffer == 0) {
     } else {
         OgxFramebuffer *fb = framebuffer_from_name(framebuffer);
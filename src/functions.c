@@ -31,7 +31,10 @@ POSSIBILITY OF SUCH DAMAGE.
 #define GL_GLEXT_PROTOTYPES 1
 #include "opengx.h"
 #include "shader.h"
+#include "skinning.h"
+#include "state.h"
 #include "types.h"
+#include "vbo.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -53,6 +56,7 @@ static const OgxProcMap s_proc_map[] = {
     PROC(glBitmap),
     PROC(glBlendFunc),
     PROC(glBufferData), /* OpenGL 1.5 */
+    PROC(glBufferQuantizationOGX), /* GL_OGX_vertex_quantization */
     PROC(glBufferSubData), /* OpenGL 1.5 */
     PROC(glCallList),
     PROC(glCallLists),
@@ -115,9 +119,12 @@ static const OgxProcMap s_proc_map[] = {
     PROC(glDisable),
     PROC(glDisableClientState),
     PROC(glDrawArrays),
+    PROC(glDrawArraysInstancedOGX), /* GL_OGX_draw_instanced */
     PROC(glDrawBuffer),
     PROC(glDrawElements),
+    PROC(glDrawElementsInstancedOGX), /* GL_OGX_draw_instanced */
     PROC(glDrawPixels),
+    PROC(glDrawRangeElements), /* OpenGL 1.2 */
     //PROC(glEdgeFlag),
     //PROC(glEdgeFlagPointer),
     //PROC(glEdgeFlagv),
@@ -236,9 +243,13 @@ static const OgxProcMap s_proc_map[] = {
     PROC(glMaterialfv),
     //PROC(glMateriali),
     //PROC(glMaterialiv),
+    PROC(glMatrixIndexPointerOGX), /* GL_OGX_matrix_palette */
     PROC(glMatrixMode),
+    PROC(glMatrixPaletteOGX), /* GL_OGX_matrix_palette */
     PROC(glMultMatrixd),
     PROC(glMultMatrixf),
+    PROC(glMultiDrawArrays), /* OpenGL 1.4 */
+    PROC(glMultiDrawElements), /* OpenGL 1.4 */
     PROC(glMultiTexCoord1d), /* OpenGL 1.3 */
     PROC(glMultiTexCoord1dv), /* OpenGL 1.3 */
     PROC(glMultiTexCoord1f), /* OpenGL 1.3 */
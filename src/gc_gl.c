@@ -54,12 +54,15 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "opengx.h"
 #include "selection.h"
 #include "shader.h"
+#include "skinning.h"
 #include "state.h"
 #include "stencil.h"
+#include "texture.h"
 #include "texture_gen_sw.h"
 #include "texture_unit.h"
 #include "utils.h"
 #include "vbo.h"
+#include "wireframe.h"
 
 #include <GL/gl.h>
 #include <gctypes.h>
@@ -85,6 +88,18 @@ static OgxEfbBuffer *s_efb_scene_buffer = NULL;
 static GXTexObj s_zbuffer_texture;
 static uint8_t s_zbuffer_texels[2 * 32] ATTRIBUTE_ALIGN(32);
 static bool s_point_sprites_was_enabled = false;
+
+/* Draw batching (see OGX_HINT_BATCH_DRAWS) */
+static struct {
+    uint8_t mode;
+    int num_draws;
+    /* The dirty bits left set after the state was applied */
+    unsigned int dirty;
+    /* The textures sampled by the batch, marked as in use once it's sent */
+    unsigned texture_units;
+    GLuint textures[MAX_TEXTURE_UNITS];
+} s_batch;
+static OgxBatchStats s_batch_stats;
 /* Force the inclusion of functions.c's TU in the build when GL functions are
  * used. In this way, if a client library (such as SDL) defines weak symbols
  * for the opengx functions it uses, a client application which actually uses
@@ -235,9 +250,11 @@ int ogx_enable_double_buffering(int double_buffering)
 int ogx_prepare_swap_buffers()
 {
     if (glparamstate.render_mode != GL_RENDER) return -1;
+    _ogx_flush_draw_batch();
     _ogx_draw_sync_token = 0;
     GX_SetDrawSync(0);
     _ogx_vbo_clear_unbound_buffers();
+    _ogx_textures_clear_retired();
     return 0;
 }
 
@@ -252,6 +269,16 @@ static int parse_hints()
     if (env) {
         if (strstr(env, "sphere_map") != NULL)
             hints |= OGX_HINT_FAST_SPHERE_MAP;
+        if (strstr(env, "indexed_arrays") != NULL)
+            hints |= OGX_HINT_INDEXED_CLIENT_ARRAYS;
+        if (strstr(env, "batch_draws") != NULL)
+            hints |= OGX_HINT_BATCH_DRAWS;
+        if (strstr(env, "cull_draws") != NULL)
+            hints |= OGX_HINT_CULL_DRAWS;
+        if (strstr(env, "bake_lists") != NULL)
+            hints |= OGX_HINT_BAKE_CALL_LISTS;
+        if (strstr(env, "inline_lists") != NULL)
+            hints |= OGX_HINT_INLINE_CALL_LISTS;
     }
 
     glparamstate.hints = hints;
@@ -572,6 +599,8 @@ void _ogx_scene_load_into_efb()
  * mostly harmless, but not clean). */
 void _ogx_efb_set_content_type_real(OgxEfbContentType content_type)
 {
+    _ogx_flush_draw_batch();
+
     /* Save existing EFB contents, if needed */
     switch (_ogx_efb_content_type) {
     case OGX_EFB_SCENE:
@@ -1022,6 +1051,60 @@ void glFrontFace(GLenum mode)
     }
 }
 
+/* Whether the vertices between glBegin() and glEnd() can be sent to the GPU
+ * in chunks (see _ogx_immediate_flush()). Polygon modes need the whole
+ * primitive, and display lists, selection and stencil drawing go through
+ * glDrawArrays(). */
+static bool can_stream_immediate(GLenum mode)
+{
+    return _ogx_draw_mode(mode).mode != 0xff &&
+        glparamstate.polygon_mode == GL_FILL &&
+        glparamstate.current_call_list.index < 0 &&
+        glparamstate.render_mode == GL_RENDER &&
+        !glparamstate.stencil.enabled &&
+        !glparamstate.current_program;
+}
+
+/* Point the client arrays to the immediate mode vertex buffer */
+static void set_immediate_arrays()
+{
+    VertexData *base = glparamstate.imm_mode.current_vertices;
+    OgxVertexAttribArray array = { 0 };
+    array.stride = sizeof(VertexData);
+    array.type = GL_FLOAT;
+
+    array.size = 3;
+    array.pointer = base->pos;
+    STATE_ARRAY(POS) = array;
+
+    if (glparamstate.imm_mode.has_normal) {
+        array.pointer = base->norm;
+        STATE_ARRAY(NRM) = array;
+    }
+
+    if (glparamstate.imm_mode.has_color) {
+        OgxVertexAttribArray color = array;
+        color.size = 4;
+        color.type = GL_UNSIGNED_BYTE;
+        color.pointer = &base->color;
+        STATE_ARRAY(CLR) = color;
+    }
+
+    array.size = 2;
+    for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+        if (glparamstate.imm_mode.has_texcoord & (1 << i)) {
+            array.pointer = base->tex[i];
+            STATE_ARRAY_TEX(i) = array;
+        }
+    }
+
+    glparamstate.cs.texcoord_enabled = glparamstate.imm_mode.has_texcoord;
+    glparamstate.cs.color_enabled = glparamstate.imm_mode.has_color;
+    glparamstate.cs.normal_enabled = glparamstate.imm_mode.has_normal;
+    glparamstate.cs.vertex_enabled = 1;
+    glparamstate.dirty.bits.dirty_attributes = 1;
+}
+
 void glBegin(GLenum mode)
 {
     // Just discard all the data!
@@ -1031,6 +1114,9 @@ void glBegin(GLenum mode)
     glparamstate.imm_mode.has_color = 0;
     glparamstate.imm_mode.has_normal = 0;
     glparamstate.imm_mode.has_texcoord = 0;
+    glparamstate.imm_mode.streaming = can_stream_immediate(mode);
+    glparamstate.imm_mode.stream_setup = 0;
+    glparamstate.imm_mode.stream_flushed = 0;
     if (!glparamstate.imm_mode.current_vertices) {
         int count = 64;
         warning("First malloc %d", errno);
@@ -1047,34 +1133,17 @@ void glBegin(GLenum mode)
 
 void glEnd()
 {
-    union client_state cs_backup = glparamstate.cs;
-    VertexData *base = glparamstate.imm_mode.current_vertices;
-    int stride = sizeof(VertexData);
+    if (glparamstate.imm_mode.streaming) {
+        _ogx_immediate_flush(true);
+        glparamstate.imm_mode.in_gl_begin = 0;
+        return;
+    }
 
+    union client_state cs_backup = glparamstate.cs;
     OgxVertexAttribArray arrays_backup[OGX_ATTR_INDEX_COUNT];
     memcpy(arrays_backup, glparamstate.arrays, sizeof(arrays_backup));
 
-    glVertexPointer(3, GL_FLOAT, stride, base->pos);
-
-    if (glparamstate.imm_mode.has_normal) {
-        glNormalPointer(GL_FLOAT, stride, base->norm);
-    }
-
-    if (glparamstate.imm_mode.has_color) {
-        glColorPointer(4, GL_UNSIGNED_BYTE, stride, &base->color);
-    }
-
-    for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
-        if (glparamstate.imm_mode.has_texcoord & (1 << i)) {
-            glparamstate.cs.active_texture = i;
-            glTexCoordPointer(2, GL_FLOAT, stride, base->tex[i]);
-        }
-    }
-
-    glparamstate.cs.texcoord_enabled = glparamstate.imm_mode.has_texcoord;
-    glparamstate.cs.color_enabled = glparamstate.imm_mode.has_color;
-    glparamstate.cs.normal_enabled = glparamstate.imm_mode.has_normal;
-    glparamstate.cs.vertex_enabled = 1;
+    set_immediate_arrays();
     glDrawArrays(glparamstate.imm_mode.prim_type, 0, glparamstate.imm_mode.current_numverts);
     glparamstate.cs = cs_backup;
     memcpy(glparamstate.arrays, arrays_backup, sizeof(arrays_backup));
@@ -1421,6 +1490,8 @@ void glClear(GLbitfield mask)
         return;
     }
 
+    _ogx_flush_draw_batch();
+
     /* Since this function is typically called at the beginning of a frame, and
      * the integration library might have draw something on the screen right
      * before (typically, a mouse cursor), we assume the scissor to be dirty
@@ -1554,6 +1625,8 @@ GLint glRenderMode(GLenum mode)
 {
     int hit_count;
 
+    _ogx_flush_draw_batch();
+
     switch (mode) {
     case GL_RENDER:
     case GL_SELECT:
@@ -1567,11 +1640,16 @@ GLint glRenderMode(GLenum mode)
     return hit_count;
 }
 
-void glFlush() {} // All commands are sent immediately to draw, no queue, so pointless
+void glFlush()
+{
+    /* All commands are sent immediately to draw, except for batched draws */
+    _ogx_flush_draw_batch();
+}
 
 // Waits for all the commands to be successfully executed
 void glFinish()
 {
+    _ogx_flush_draw_batch();
     GX_DrawDone(); // Be careful, WaitDrawDone waits for the DD command, this sends AND waits for it
 }
 
@@ -1674,11 +1752,13 @@ void glPointSize(GLfloat size)
 {
     unsigned int gxsize = size;
     if (gxsize > 255) gxsize = 255;
+    _ogx_flush_draw_batch();
     GX_SetPointSize(gxsize, GX_TO_ONE);
 }
 
 void glLineWidth(GLfloat width)
 {
+    _ogx_flush_draw_batch();
     GX_SetLineWidth((unsigned int)(width * 16), GX_TO_ZERO);
 }
 
@@ -2219,7 +2299,9 @@ OgxDrawMode _ogx_draw_mode(GLenum mode)
 {
     OgxDrawMode dm = { 0xff, false };
 
-    if (glparamstate.polygon_mode != GL_FILL) {
+    /* The polygon mode does not affect points and lines */
+    if (glparamstate.polygon_mode != GL_FILL &&
+        _ogx_wireframe_is_polygon(mode)) {
         if (glparamstate.polygon_mode == GL_POINT) {
             dm.mode = GX_POINTS;
         } else { // GL LINE
@@ -2273,10 +2355,10 @@ static void setup_fog()
      * 3. It does not support the "density" parameter
      */
 
+    color = gxcol_new_fv(glparamstate.fog.color);
     if (glparamstate.fog.enabled) {
         get_projection_info(glparamstate.projection_matrix, &proj_type, &near, &far);
 
-        color = gxcol_new_fv(glparamstate.fog.color);
         switch (glparamstate.fog.mode) {
         case GL_EXP: mode = GX_FOG_EXP; break;
         case GL_EXP2: mode = GX_FOG_EXP2; break;
@@ -2564,60 +2646,108 @@ void _ogx_apply_state()
     glparamstate.dirty.bits.dirty_z = 0;
 }
 
+/* GX_Begin() takes a 16-bit vertex count */
+#define MAX_GX_VERTICES 0xffff
+
+static void emit_vertices(const OgxDrawData *draw_data, bool elements,
+                          int start, int count, bool loop)
+{
+    if (elements) {
+        const char *indices = draw_data->indices;
+        _ogx_arrays_emit_elements(
+            indices + start * sizeof_gl_type(draw_data->type),
+            draw_data->type, count, loop);
+    } else {
+        _ogx_arrays_emit_range(draw_data->first + start, count, loop);
+    }
+}
+
+/* Emits the vertices of the draw; if they don't fit into a single GX
+ * primitive, they are split into several ones, taking care of repeating the
+ * vertices shared by consecutive chunks of strips and fans. */
+static void draw_vertices(const OgxDrawData *draw_data, bool elements)
+{
+    uint8_t mode = draw_data->gxmode.mode;
+    bool loop = draw_data->gxmode.loop;
+    int count = draw_data->count;
+    if (count + loop <= MAX_GX_VERTICES) {
+        GX_Begin(mode, _ogx_arrays_vtxfmt(), count + loop);
+        emit_vertices(draw_data, elements, 0, count, loop);
+        GX_End();
+        return;
+    }
+
+    /* The chunk size of independent primitives must be a multiple of their
+     * vertex count; for triangle strips it must be even, so that the winding
+     * of the triangles is preserved. The room for the vertex closing a line
+     * loop is also reserved. */
+    int chunk = MAX_GX_VERTICES, overlap = 0;
+    bool fan = false;
+    switch (mode) {
+    case GX_LINES: chunk -= MAX_GX_VERTICES % 2; break;
+    case GX_TRIANGLES: chunk -= MAX_GX_VERTICES % 3; break;
+    case GX_QUADS: chunk -= MAX_GX_VERTICES % 4; break;
+    case GX_LINESTRIP: chunk -= 1; overlap = 1; break;
+    case GX_TRIANGLESTRIP: chunk -= 1; overlap = 2; break;
+    case GX_TRIANGLEFAN: overlap = 1; fan = true; break;
+    }
+
+    for (int start = 0; ; ) {
+        /* Each fan chunk starts from the first vertex */
+        bool first_vertex = fan && start > 0;
+        int n = count - start;
+        bool last = n <= chunk - first_vertex;
+        if (!last) n = chunk - first_vertex;
+        bool close_loop = last && loop;
+
+        GX_Begin(mode, _ogx_arrays_vtxfmt(), first_vertex + n + close_loop);
+        if (first_vertex) emit_vertices(draw_data, elements, 0, 1, false);
+        emit_vertices(draw_data, elements, start, n, false);
+        if (close_loop) emit_vertices(draw_data, elements, 0, 1, false);
+        GX_End();
+
+        if (last) break;
+        start += n - overlap;
+    }
+}
+
 static void draw_arrays_general(const OgxDrawData *draw_data)
 {
-    GLsizei count = draw_data->count;
-    GLsizei first = draw_data->first;
     // Invalidate vertex data as may have been modified by the user
     GX_InvVtxCache();
 
-    bool loop = draw_data->gxmode.loop;
-    GX_Begin(draw_data->gxmode.mode, GX_VTXFMT0, count + loop);
-    int i;
-    for (i = 0; i < count + loop; i++) {
-        int j = i % count + first;
-        _ogx_arrays_process_element(j);
-    }
-    GX_End();
+    draw_vertices(draw_data, false);
+}
+
+/* The flags for the stencil drawing: the matrix palette has already been set
+ * up by _ogx_skinning_setup_draw() */
+static OgxDrawFlags skinning_flags()
+{
+    return _ogx_skinning_enabled() ?
+        OGX_DRAW_FLAG_MATRIX_INDEX : OGX_DRAW_FLAG_NONE;
 }
 
 static void flat_draw_geometry(void *cb_data)
 {
     OgxDrawData *data = cb_data;
 
-    _ogx_arrays_setup_draw(data, OGX_DRAW_FLAG_FLAT);
-    /* TODO: we could use C++ templates here too, to build more effective
-     * drawing functions that only process the data we need. */
+    _ogx_arrays_setup_draw(data, OGX_DRAW_FLAG_FLAT | skinning_flags());
     draw_arrays_general(data);
 }
 
 static void draw_elements_general(const OgxDrawData *draw_data)
 {
-    const GLvoid *indices = draw_data->indices;
-    GLsizei count = draw_data->count;
-
     // Invalidate vertex data as may have been modified by the user
     GX_InvVtxCache();
 
-    if (glparamstate.bound_vbo_element_array) {
-        indices = _ogx_vbo_get_data(glparamstate.bound_vbo_element_array,
-                                    indices);
-    }
-
-    bool loop = draw_data->gxmode.loop;
-    GX_Begin(draw_data->gxmode.mode, GX_VTXFMT0, count + loop);
-    for (int i = 0; i < count + loop; i++) {
-        int index = read_index(indices, draw_data->type, i % count);
-        _ogx_arrays_process_element(index);
-    }
-    GX_End();
+    draw_vertices(draw_data, true);
 }
 
 static void flat_draw_elements(void *cb_data)
 {
     OgxDrawData *data = cb_data;
 
-    _ogx_arrays_setup_draw(data, OGX_DRAW_FLAG_FLAT);
+    _ogx_arrays_setup_draw(data, OGX_DRAW_FLAG_FLAT | skinning_flags());
     draw_elements_general(data);
 }
 
@@ -2661,12 +2791,13 @@ void glArrayElement(GLint i)
     }
 }
 
-static bool setup_draw(const OgxDrawData *draw_data)
+static bool setup_draw_with_flags(const OgxDrawData *draw_data,
+                                  OgxDrawFlags flags)
 {
     _ogx_efb_set_content_type(OGX_EFB_SCENE);
 
     if (!glparamstate.current_program) {
-        _ogx_arrays_setup_draw(draw_data, OGX_DRAW_FLAG_NONE);
+        _ogx_arrays_setup_draw(draw_data, flags);
 
         /* Note that _ogx_setup_render_stages() uses some information from the
          * vertex arrays computed by _ogx_arrays_setup_draw(), so it must be called
@@ -2681,6 +2812,11 @@ static bool setup_draw(const OgxDrawData *draw_data)
     return true;
 }
 
+static bool setup_draw(const OgxDrawData *draw_data)
+{
+    return setup_draw_with_flags(draw_data, OGX_DRAW_FLAG_NONE);
+}
+
 void _ogx_update_matrices()
 {
     if (glparamstate.dirty.bits.dirty_matrices) {
@@ -2689,12 +2825,259 @@ void _ogx_update_matrices()
     }
 }
 
-static void draw_done()
+static bool is_batchable_mode(OgxDrawMode gxmode)
+{
+    if (gxmode.loop) return false;
+    /* Strips and fans cannot be merged */
+    switch (gxmode.mode) {
+    case GX_POINTS:
+    case GX_LINES:
+    case GX_TRIANGLES:
+    case GX_QUADS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool can_batch(OgxDrawMode gxmode)
+{
+    return (glparamstate.hints & OGX_HINT_BATCH_DRAWS) &&
+        is_batchable_mode(gxmode) &&
+        !glparamstate.current_program &&
+        !glparamstate.stencil.enabled &&
+        glparamstate.render_mode == GL_RENDER &&
+        !_ogx_skinning_enabled();
+}
+
+/* Called after the state has been setup for a draw: instead of drawing the
+ * vertices, start a new batch with them. */
+static bool start_batch(OgxDrawMode gxmode, int first, int count)
+{
+    if (!can_batch(gxmode) || count > 0xffff) return false;
+    if (!_ogx_arrays_batch_append(first, count)) return false;
+
+    s_batch.mode = gxmode.mode;
+    s_batch.num_draws = 1;
+    s_batch.dirty = glparamstate.dirty.all;
+    s_batch.texture_units = _ogx_textures_get_used(s_batch.textures);
+    return true;
+}
+
+/* Try to append the vertices to the current batch; this is possible only if
+ * nothing except for the vertex arrays has changed since the batch was
+ * started. */
+static bool append_to_batch(OgxDrawMode gxmode, int first, int count)
+{
+    union dirty_union allowed = { .bits = {
+        .dirty_attributes = 1,
+        .dirty_clearz = 1,
+    }};
+
+    if (gxmode.mode != s_batch.mode || !can_batch(gxmode) ||
+        (glparamstate.dirty.all & ~allowed.all) !=
+        (s_batch.dirty & ~allowed.all) ||
+        _ogx_arrays_batch_count() + count > 0xffff) return false;
+
+    if (glparamstate.dirty.bits.dirty_attributes ||
+        point_sprites_changed(gxmode.mode))
+        _ogx_update_vertex_array_readers(gxmode);
+
+    if (!_ogx_arrays_batch_append(first, count)) return false;
+
+    s_batch.num_draws++;
+    s_batch_stats.merged_draw_calls++;
+    glparamstate.draw_count++;
+    return true;
+}
+
+void _ogx_flush_draw_batch()
+{
+    if (s_batch.num_draws == 0) return;
+
+    GX_Begin(s_batch.mode, _ogx_arrays_vtxfmt(), _ogx_arrays_batch_count());
+    _ogx_arrays_batch_emit();
+    GX_End();
+    s_batch.num_draws = 0;
+    _ogx_textures_mark_in_use(s_batch.texture_units, s_batch.textures);
+}
+
+void ogx_get_batch_stats(OgxBatchStats *stats)
+{
+    *stats = s_batch_stats;
+}
+
+/* Returns true if the positions in the given range of the vertex array are
+ * all outside of the view frustum. This is only checked when the positions
+ * are read from a VBO, whose bounding box can be cached; count is -1 if the
+ * vertices are accessed by index. */
+static bool is_draw_culled(int first, int count)
+{
+    const OgxVertexAttribArray *array = &STATE_ARRAY(POS);
+    if (!(glparamstate.hints & OGX_HINT_CULL_DRAWS) ||
+        !glparamstate.cs.vertex_enabled || array->vbo == 0 ||
+        glparamstate.current_program ||
+        glparamstate.render_mode != GL_RENDER ||
+        /* The bones move the vertices around */
+        _ogx_skinning_enabled()) return false;
+
+    OgxVboBoundsKey key = {
+        (uintptr_t)array->pointer, array->stride, array->type, array->size,
+        first, count,
+    };
+    OgxVboBounds bounds;
+    if (!_ogx_vbo_get_bounds(array->vbo, &key, &bounds)) return false;
+
+    /* Transform the corners of the box into clip coordinates: the draw can be
+     * skipped if they all lie on the outer side of the same frustum plane. */
+    const Mtx *mv = glparamstate.mv_ptr;
+    const Mtx44 *proj = glparamstate.proj_ptr;
+    uint8_t outside_all = 0x3f;
+    for (int i = 0; i < 8; i++) {
+        float v[3] = {
+            (i & 1) ? bounds.max[0] : bounds.min[0],
+            (i & 2) ? bounds.max[1] : bounds.min[1],
+            (i & 4) ? bounds.max[2] : bounds.min[2],
+        };
+        float eye[4], clip[4];
+        for (int r = 0; r < 3; r++) {
+            eye[r] = (*mv)[r][0] * v[0] + (*mv)[r][1] * v[1] +
+                (*mv)[r][2] * v[2] + (*mv)[r][3];
+        }
+        eye[3] = 1.0f;
+        for (int r = 0; r < 4; r++) {
+            clip[r] = (*proj)[r][0] * eye[0] + (*proj)[r][1] * eye[1] +
+                (*proj)[r][2] * eye[2] + (*proj)[r][3] * eye[3];
+        }
+        uint8_t outside = 0;
+        for (int c = 0; c < 3; c++) {
+            if (clip[c] < -clip[3]) outside |= 1 << (c * 2);
+            if (clip[c] > clip[3]) outside |= 2 << (c * 2);
+        }
+        outside_all &= outside;
+        if (!outside_all) return false;
+    }
+    return true;
+}
+
+/* batched is true if the vertices have been queued in the draw batch, whose
+ * textures are marked as in use when it is flushed */
+static void draw_done(bool batched)
 {
     _ogx_arrays_draw_done();
+    if (!batched) _ogx_textures_set_in_use();
     _ogx_shader_draw_done();
 }
 
+/* Common implementation of glDrawElements() and glDrawRangeElements() */
+static void draw_elements(OgxDrawData *draw_data)
+{
+    OgxDrawMode gxmode = draw_data->gxmode;
+
+    s_batch_stats.draw_calls++;
+    if (is_draw_culled(0, -1)) {
+        s_batch_stats.culled_draw_calls++;
+        return;
+    }
+    _ogx_flush_draw_batch();
+
+    if (glparamstate.dirty.bits.dirty_attributes ||
+        /* Point sprites need special handling */
+        point_sprites_changed(gxmode.mode))
+        _ogx_update_vertex_array_readers(gxmode);
+
+    /* If VBOs are in use, make sure their data has been updated */
+    ppcsync();
+
+    VboType vbo = glparamstate.bound_vbo_element_array;
+    if (vbo) {
+        /* The index range lets the vertices be sent as 8-bit indices; for
+         * element buffers, it's cheap to find it out */
+        if (!draw_data->has_index_range) {
+            draw_data->has_index_range =
+                _ogx_vbo_get_index_range(vbo, draw_data->indices,
+                                         draw_data->type, draw_data->count,
+                                         &draw_data->min_index,
+                                         &draw_data->max_index);
+        }
+        draw_data->indices = _ogx_vbo_get_data(vbo, draw_data->indices);
+    }
+
+    _ogx_update_matrices();
+    OgxDrawFlags flags = _ogx_skinning_setup_draw();
+    if (glparamstate.stencil.enabled) {
+        _ogx_gpu_resources_push();
+        _ogx_stencil_draw(flat_draw_elements, draw_data);
+        _ogx_gpu_resources_pop();
+    }
+
+    _ogx_gpu_resources_push();
+
+    bool should_draw = setup_draw_with_flags(draw_data, flags);
+    if (should_draw) {
+        draw_elements_general(draw_data);
+        glparamstate.draw_count++;
+    }
+    draw_done(false);
+
+    _ogx_gpu_resources_pop();
+}
+
+static inline bool is_wireframe(GLenum mode)
+{
+    return glparamstate.polygon_mode == GL_LINE &&
+        _ogx_wireframe_is_polygon(mode);
+}
+
+/* Edge list of the last glDrawArrays() call drawn in wireframe mode */
+static struct {
+    GLenum mode;
+    GLint first;
+    GLsizei count;
+    OgxEdgeList edges;
+} s_array_edges;
+
+/* With glPolygonMode(GL_LINE), the unique edges of the polygons are drawn as
+ * GX_LINES. If type is 0, the vertices are taken from the arrays, starting at
+ * first; otherwise, from the given indices. */
+static void draw_wireframe(GLenum mode, GLint first, GLsizei count,
+                           GLenum type, const GLvoid *indices)
+{
+    OgxEdgeList client_edges = { NULL };
+    const OgxEdgeList *edges = NULL;
+    VboType vbo = glparamstate.bound_vbo_element_array;
+    if (type == 0) {
+        if (s_array_edges.mode != mode || s_array_edges.first != first ||
+            s_array_edges.count != count) {
+            _ogx_wireframe_free_edges(&s_array_edges.edges);
+            _ogx_wireframe_build_edges(mode, NULL, 0, first, count,
+                                       &s_array_edges.edges);
+            s_array_edges.mode = mode;
+            s_array_edges.first = first;
+            s_array_edges.count = count;
+        }
+        if (s_array_edges.edges.count > 0) edges = &s_array_edges.edges;
+    } else if (vbo) {
+        edges = _ogx_vbo_get_edges(vbo, mode, indices, type, count);
+    } else if (_ogx_wireframe_build_edges(mode, indices, type, 0, count,
+                                          &client_edges)) {
+        edges = &client_edges;
+    }
+
+    if (edges) {
+        OgxDrawMode gxmode = { GX_LINES, false };
+        OgxDrawData draw_data = {
+            gxmode, edges->count, 0, GL_UNSIGNED_INT, edges->indices,
+            true, edges->min_index, edges->max_index,
+        };
+        /* The edge indices don't live in the element buffer */
+        glparamstate.bound_vbo_element_array = 0;
+        draw_elements(&draw_data);
+        glparamstate.bound_vbo_element_array = vbo;
+    }
+    _ogx_wireframe_free_edges(&client_edges);
+}
+
 void glDrawArrays(GLenum mode, GLint first, GLsizei count)
 {
     OgxDrawMode gxmode = _ogx_draw_mode(mode);
@@ -2703,6 +3086,21 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count)
 
     HANDLE_CALL_LIST(DRAW_ARRAYS, mode, first, count);
 
+    if (is_wireframe(mode)) {
+        draw_wireframe(mode, first, count, 0, NULL);
+        return;
+    }
+
+    s_batch_stats.draw_calls++;
+    if (is_draw_culled(first, count)) {
+        s_batch_stats.culled_draw_calls++;
+        return;
+    }
+    if (s_batch.num_draws > 0) {
+        if (append_to_batch(gxmode, first, count)) return;
+        _ogx_flush_draw_batch();
+    }
+
     if (glparamstate.dirty.bits.dirty_attributes ||
         /* Point sprites need special handling */
         point_sprites_changed(gxmode.mode))
@@ -2712,6 +3110,7 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count)
     ppcsync();
 
     _ogx_update_matrices();
+    OgxDrawFlags flags = _ogx_skinning_setup_draw();
     OgxDrawData draw_data = { gxmode, count, first, };
     if (glparamstate.stencil.enabled) {
         _ogx_gpu_resources_push();
@@ -2721,12 +3120,15 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count)
 
     _ogx_gpu_resources_push();
 
-    bool should_draw = setup_draw(&draw_data);
+    bool should_draw = setup_draw_with_flags(&draw_data, flags);
+    bool batched = false;
     if (should_draw) {
-        draw_arrays_general(&draw_data);
+        batched = start_batch(gxmode, first, count);
+        if (!batched)
+            draw_arrays_general(&draw_data);
         glparamstate.draw_count++;
     }
-    draw_done();
+    draw_done(batched);
 
     _ogx_gpu_resources_pop();
 }
@@ -2739,34 +3141,530 @@ void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indic
 
     HANDLE_CALL_LIST(DRAW_ELEMENTS, mode, count, type, indices);
 
+    if (is_wireframe(mode)) {
+        draw_wireframe(mode, 0, count, type, indices);
+        return;
+    }
+
+    OgxDrawData draw_data = { gxmode, count, 0, type, indices };
+    draw_elements(&draw_data);
+}
+
+void glDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count,
+                         GLenum type, const GLvoid *indices)
+{
+    if (end < start || count < 0) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    OgxDrawMode gxmode = _ogx_draw_mode(mode);
+    if (gxmode.mode == 0xff)
+        return;
+
+    HANDLE_CALL_LIST(DRAW_ELEMENTS, mode, count, type, indices);
+
+    if (is_wireframe(mode)) {
+        draw_wireframe(mode, 0, count, type, indices);
+        return;
+    }
+
+    OgxDrawData draw_data = {
+        gxmode, count, 0, type, indices, true, start, end,
+    };
+    draw_elements(&draw_data);
+}
+
+/* The parameters of glMultiDrawArrays() and glMultiDrawElements() */
+typedef struct {
+    OgxDrawMode gxmode;
+    const GLint *first;
+    const GLsizei *count;
+    GLenum type;
+    const GLvoid *const *indices;
+    GLsizei drawcount;
+} MultiDrawData;
+
+static void fill_sub_draw(const MultiDrawData *data, int i,
+                          OgxDrawData *draw_data)
+{
+    draw_data->gxmode = data->gxmode;
+    draw_data->count = data->count[i];
+    if (data->first) {
+        draw_data->first = data->first[i];
+    } else {
+        draw_data->type = data->type;
+        draw_data->indices = data->indices[i];
+        if (glparamstate.bound_vbo_element_array) {
+            draw_data->indices =
+                _ogx_vbo_get_data(glparamstate.bound_vbo_element_array,
+                                  draw_data->indices);
+        }
+    }
+}
+
+static bool is_sub_draw_culled(const MultiDrawData *data, int i)
+{
+    if (data->count[i] <= 0) return true;
+    return data->first ?
+        is_draw_culled(data->first[i], data->count[i]) : is_draw_culled(0, -1);
+}
+
+/* Emits all the sub-draws back to back: the vertex format and the render
+ * stages have already been set up */
+static void multi_draw_general(const MultiDrawData *data)
+{
+    for (int i = 0; i < data->drawcount; i++) {
+        if (is_sub_draw_culled(data, i)) continue;
+
+        OgxDrawData draw_data = { 0 };
+        fill_sub_draw(data, i, &draw_data);
+        if (data->first) {
+            draw_arrays_general(&draw_data);
+        } else {
+            draw_elements_general(&draw_data);
+        }
+    }
+}
+
+static void flat_multi_draw(void *cb_data)
+{
+    const MultiDrawData *data = cb_data;
+    /* The indices are not needed for setting up the vertex format */
+    OgxDrawData draw_data = { data->gxmode, };
+
+    _ogx_arrays_setup_draw(&draw_data, OGX_DRAW_FLAG_FLAT | skinning_flags());
+    multi_draw_general(data);
+}
+
+/* Common implementation of glMultiDrawArrays() and glMultiDrawElements(): the
+ * GL state is applied and the vertex format is set up only once, then the
+ * sub-draws are emitted one after the other. */
+static void multi_draw(const MultiDrawData *data)
+{
+    s_batch_stats.draw_calls += data->drawcount;
+    int num_visible = 0;
+    for (int i = 0; i < data->drawcount; i++) {
+        if (is_sub_draw_culled(data, i)) {
+            if (data->count[i] > 0) s_batch_stats.culled_draw_calls++;
+        } else {
+            num_visible++;
+        }
+    }
+    if (num_visible == 0) return;
+
+    _ogx_flush_draw_batch();
+
     if (glparamstate.dirty.bits.dirty_attributes ||
         /* Point sprites need special handling */
-        point_sprites_changed(gxmode.mode))
-        _ogx_update_vertex_array_readers(gxmode);
+        point_sprites_changed(data->gxmode.mode))
+        _ogx_update_vertex_array_readers(data->gxmode);
 
     /* If VBOs are in use, make sure their data has been updated */
     ppcsync();
 
     _ogx_update_matrices();
-    OgxDrawData draw_data = { gxmode, count, 0, type, indices };
+    OgxDrawFlags flags = _ogx_skinning_setup_draw();
     if (glparamstate.stencil.enabled) {
         _ogx_gpu_resources_push();
-        _ogx_stencil_draw(flat_draw_elements, &draw_data);
+        _ogx_stencil_draw(flat_multi_draw, (void *)data);
         _ogx_gpu_resources_pop();
     }
 
     _ogx_gpu_resources_push();
 
-    bool should_draw = setup_draw(&draw_data);
+    /* Since the vertex format is shared by all sub-draws, the optimizations
+     * depending on the index values of a single draw are not used */
+    OgxDrawData draw_data = { data->gxmode, };
+    bool should_draw = setup_draw_with_flags(&draw_data, flags);
     if (should_draw) {
-        draw_elements_general(&draw_data);
+        multi_draw_general(data);
         glparamstate.draw_count++;
     }
-    draw_done();
+    draw_done(false);
 
     _ogx_gpu_resources_pop();
 }
 
+/* GL requires the whole call to fail, before anything is drawn, if any of the
+ * counts is negative */
+static bool are_counts_valid(const GLsizei *count, GLsizei drawcount)
+{
+    for (int i = 0; i < drawcount; i++) {
+        if (count[i] < 0) return false;
+    }
+    return true;
+}
+
+void glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count,
+                       GLsizei drawcount)
+{
+    if (drawcount < 0 || !are_counts_valid(count, drawcount)) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    OgxDrawMode gxmode = _ogx_draw_mode(mode);
+    if (gxmode.mode == 0xff)
+        return;
+
+    /* Display lists, shader programs (whose setup callback might depend on
+     * the draw parameters) and wireframes go through the single draw path */
+    if (glparamstate.current_call_list.index >= 0 ||
+        glparamstate.current_program || is_wireframe(mode)) {
+        for (int i = 0; i < drawcount; i++) {
+            if (count[i] > 0) glDrawArrays(mode, first[i], count[i]);
+        }
+        return;
+    }
+
+    MultiDrawData data = { gxmode, first, count, 0, NULL, drawcount };
+    multi_draw(&data);
+}
+
+void glMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
+                         const GLvoid *const *indices, GLsizei drawcount)
+{
+    if (drawcount < 0 || !are_counts_valid(count, drawcount)) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    OgxDrawMode gxmode = _ogx_draw_mode(mode);
+    if (gxmode.mode == 0xff)
+        return;
+
+    if (glparamstate.current_call_list.index >= 0 ||
+        glparamstate.current_program || is_wireframe(mode)) {
+        for (int i = 0; i < drawcount; i++) {
+            if (count[i] > 0) glDrawElements(mode, count[i], type, indices[i]);
+        }
+        return;
+    }
+
+    MultiDrawData data = { gxmode, NULL, count, type, indices, drawcount };
+    multi_draw(&data);
+}
+
+/* Instanced drawing (GL_OGX_draw_instanced): the modelview matrix of each
+ * instance is loaded into one of the position matrix slots which are not
+ * used by opengx, and the vertices of the instance are prefixed by the slot
+ * index. In this way, several instances can be drawn as a single primitive. */
+typedef struct {
+    GLenum mode;
+    bool elements;
+    OgxDrawData draw_data;
+    GLsizei instancecount;
+    const GLfloat *matrices;
+} InstancedDrawData;
+
+static bool can_draw_instanced(GLenum mode)
+{
+    if (ogx_gpu_resources->pnmtx_end <= ogx_gpu_resources->pnmtx_first ||
+        glparamstate.current_call_list.index >= 0 ||
+        glparamstate.current_program ||
+        is_wireframe(mode) ||
+        glparamstate.render_mode != GL_RENDER ||
+        glparamstate.stencil.enabled ||
+        _ogx_skinning_enabled() ||
+        /* Clip planes and texture coordinate generation use the modelview
+         * matrix in the texture matrices */
+        glparamstate.clip_plane_mask != 0) return false;
+
+    for (int tex = 0; tex < MAX_TEXTURE_UNITS; tex++) {
+        if (glparamstate.texture_unit[tex].gen_enabled) return false;
+    }
+    return true;
+}
+
+static void draw_instance_vertices(const InstancedDrawData *data,
+                                   int num_instances, int first_slot)
+{
+    const OgxDrawData *draw_data = &data->draw_data;
+    if (num_instances == 1) {
+        _ogx_arrays_set_matrix_index(GX_PNMTX0 + first_slot * 3);
+        draw_vertices(draw_data, data->elements);
+        return;
+    }
+
+    bool loop = draw_data->gxmode.loop;
+    int count = draw_data->count + loop;
+    GX_Begin(draw_data->gxmode.mode, _ogx_arrays_vtxfmt(),
+             count * num_instances);
+    for (int i = 0; i < num_instances; i++) {
+        _ogx_arrays_set_matrix_index(GX_PNMTX0 + (first_slot + i) * 3);
+        if (data->elements) {
+            _ogx_arrays_emit_elements(draw_data->indices, draw_data->type,
+                                      draw_data->count, loop);
+        } else {
+            _ogx_arrays_emit_range(draw_data->first, draw_data->count, loop);
+        }
+    }
+    GX_End();
+}
+
+static void load_instance_matrix(const GLfloat *m, int slot)
+{
+    Mtx mtx, mv;
+    gl_matrix_to_gx(m, mtx);
+    guMtxConcat(glparamstate.modelview_matrix, mtx, mv);
+    GX_LoadPosMtxImm(mv, GX_PNMTX0 + slot * 3);
+
+    if (glparamstate.lighting.enabled) {
+        Mtx mvinverse, normalm;
+        guMtxInverse(mv, mvinverse);
+        guMtxTranspose(mvinverse, normalm);
+        GX_LoadNrmMtxImm(normalm, GX_PNMTX0 + slot * 3);
+    }
+}
+
+static void draw_instanced(InstancedDrawData *data)
+{
+    OgxDrawData draw_data = data->draw_data;
+    OgxDrawMode gxmode = draw_data.gxmode;
+
+    s_batch_stats.draw_calls += data->instancecount;
+
+    _ogx_flush_draw_batch();
+
+    if (glparamstate.dirty.bits.dirty_attributes ||
+        /* Point sprites need special handling */
+        point_sprites_changed(gxmode.mode))
+        _ogx_update_vertex_array_readers(gxmode);
+
+    /* If VBOs are in use, make sure their data has been updated */
+    ppcsync();
+
+    if (data->elements && glparamstate.bound_vbo_element_array) {
+        data->draw_data.indices =
+            _ogx_vbo_get_data(glparamstate.bound_vbo_element_array,
+                              draw_data.indices);
+        draw_data.indices = data->draw_data.indices;
+    }
+
+    _ogx_update_matrices();
+    _ogx_gpu_resources_push();
+
+    /* Book all the free position matrices */
+    int first_slot = ogx_gpu_resources->pnmtx_first;
+    int num_slots = ogx_gpu_resources->pnmtx_end - first_slot;
+    ogx_gpu_resources->pnmtx_first = ogx_gpu_resources->pnmtx_end;
+
+    /* Instances of independent primitives can be merged into one, as long as
+     * the vertex count fits in GX_Begin()'s 16 bits */
+    int per_primitive = 1;
+    if (is_batchable_mode(gxmode)) {
+        per_primitive = 0xffff / draw_data.count;
+        if (per_primitive > num_slots) per_primitive = num_slots;
+        if (per_primitive < 1) per_primitive = 1;
+    }
+
+    bool should_draw = setup_draw_with_flags(&draw_data,
+                                             OGX_DRAW_FLAG_MATRIX_INDEX);
+    if (should_draw) {
+        GX_InvVtxCache();
+        for (int base = 0; base < data->instancecount; base += num_slots) {
+            int n = data->instancecount - base;
+            if (n > num_slots) n = num_slots;
+            for (int i = 0; i < n; i++) {
+                load_instance_matrix(data->matrices + (base + i) * 16,
+                                     first_slot + i);
+            }
+            for (int i = 0; i < n; i += per_primitive) {
+                int num_instances = n - i;
+                if (num_instances > per_primitive)
+                    num_instances = per_primitive;
+                draw_instance_vertices(data, num_instances, first_slot + i);
+            }
+        }
+        glparamstate.draw_count++;
+    }
+    draw_done(false);
+
+    _ogx_gpu_resources_pop();
+}
+
+/* Fallback for the cases not supported by draw_instanced() */
+static void draw_instances_separately(const InstancedDrawData *data)
+{
+    const OgxDrawData *draw_data = &data->draw_data;
+    char matrixmode = glparamstate.matrixmode;
+    glparamstate.matrixmode = 1; /* GL_MODELVIEW */
+    for (int i = 0; i < data->instancecount; i++) {
+        glPushMatrix();
+        glMultMatrixf(data->matrices + i * 16);
+        if (data->elements) {
+            glDrawElements(data->mode, draw_data->count, draw_data->type,
+                           draw_data->indices);
+        } else {
+            glDrawArrays(data->mode, draw_data->first, draw_data->count);
+        }
+        glPopMatrix();
+    }
+    glparamstate.matrixmode = matrixmode;
+}
+
+void glDrawArraysInstancedOGX(GLenum mode, GLint first, GLsizei count,
+                              GLsizei instancecount, const GLfloat *matrices)
+{
+    if (count < 0 || instancecount < 0) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    OgxDrawMode gxmode = _ogx_draw_mode(mode);
+    if (gxmode.mode == 0xff || count == 0)
+        return;
+
+    InstancedDrawData data = {
+        mode, false, { gxmode, count, first, }, instancecount, matrices,
+    };
+    if (can_draw_instanced(mode)) {
+        if (instancecount > 0) draw_instanced(&data);
+    } else {
+        draw_instances_separately(&data);
+    }
+}
+
+void glDrawElementsInstancedOGX(GLenum mode, GLsizei count, GLenum type,
+                                const GLvoid *indices, GLsizei instancecount,
+                                const GLfloat *matrices)
+{
+    if (count < 0 || instancecount < 0) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    OgxDrawMode gxmode = _ogx_draw_mode(mode);
+    if (gxmode.mode == 0xff || count == 0)
+        return;
+
+    InstancedDrawData data = {
+        mode, true, { gxmode, count, 0, type, indices }, instancecount,
+        matrices,
+    };
+    if (can_draw_instanced(mode)) {
+        if (instancecount > 0) draw_instanced(&data);
+    } else {
+        draw_instances_separately(&data);
+    }
+}
+
+static uint8_t immediate_attributes()
+{
+    return glparamstate.imm_mode.has_color |
+        (glparamstate.imm_mode.has_normal << 1) |
+        (glparamstate.imm_mode.has_texcoord << 2);
+}
+
+/* Sets up the GX state for drawing the immediate mode vertex buffer. This is
+ * done once per glBegin()/glEnd() block, unless a new vertex attribute
+ * appears halfway. */
+static void setup_immediate_stream(OgxDrawMode gxmode, int count)
+{
+    if (!glparamstate.imm_mode.stream_setup) {
+        _ogx_flush_draw_batch();
+    } else {
+        /* Release the resources allocated by the previous setup, or the new
+         * one would allocate its TEV stages and texture slots after them */
+        _ogx_gpu_resources_pop();
+    }
+    _ogx_gpu_resources_push();
+
+    union client_state cs_backup = glparamstate.cs;
+    OgxVertexAttribArray arrays_backup[OGX_ATTR_INDEX_COUNT];
+    memcpy(arrays_backup, glparamstate.arrays, sizeof(arrays_backup));
+
+    set_immediate_arrays();
+    _ogx_update_vertex_array_readers(gxmode);
+    _ogx_update_matrices();
+    OgxDrawData draw_data = { gxmode, count, 0, };
+    glparamstate.imm_mode.stream_should_draw = setup_draw(&draw_data);
+
+    /* The readers stay valid until glEnd(), but they don't match the client
+     * arrays */
+    if (glparamstate.cs.as_int != cs_backup.as_int)
+        glparamstate.dirty.bits.dirty_tev = 1;
+    glparamstate.cs = cs_backup;
+    memcpy(glparamstate.arrays, arrays_backup, sizeof(arrays_backup));
+    glparamstate.dirty.bits.dirty_attributes = 1;
+
+    glparamstate.imm_mode.stream_setup = 1;
+    glparamstate.imm_mode.stream_attributes = immediate_attributes();
+}
+
+/* Sends the vertices accumulated since glBegin() (or since the last flush) to
+ * the GPU. If end is false, the vertex buffer holds IMM_CHUNK_SIZE vertices,
+ * and the vertices needed to continue the primitive are kept in the buffer. */
+void _ogx_immediate_flush(bool end)
+{
+    VertexData *vertices = glparamstate.imm_mode.current_vertices;
+    int count = glparamstate.imm_mode.current_numverts;
+    OgxDrawMode gxmode = _ogx_draw_mode(glparamstate.imm_mode.prim_type);
+
+    int min_count, keep_first = 0, keep_last = 0;
+    switch (gxmode.mode) {
+    case GX_POINTS: min_count = 1; break;
+    case GX_LINES: min_count = 2; break;
+    case GX_LINESTRIP: min_count = 2; keep_last = 1; break;
+    case GX_TRIANGLES: min_count = 3; break;
+    case GX_TRIANGLESTRIP: min_count = 3; keep_last = 2; break;
+    case GX_TRIANGLEFAN: min_count = 3; keep_first = 1; keep_last = 1; break;
+    default: min_count = 4; break; /* GX_QUADS */
+    }
+
+    static VertexData loop_start;
+    bool loop = false;
+    if (gxmode.loop) {
+        if (!end) {
+            if (!glparamstate.imm_mode.stream_flushed) loop_start = vertices[0];
+        } else if (glparamstate.imm_mode.stream_flushed) {
+            /* Close the loop by hand, since the first vertex is gone */
+            vertices[count++] = loop_start;
+        } else {
+            loop = count >= min_count;
+        }
+    }
+
+    int emit_count = count;
+    if (gxmode.mode == GX_LINES || gxmode.mode == GX_TRIANGLES ||
+        gxmode.mode == GX_QUADS) {
+        /* Incomplete primitives are ignored */
+        emit_count -= count % min_count;
+    }
+    if (emit_count < min_count) emit_count = 0;
+
+    if (emit_count > 0 &&
+        (!glparamstate.imm_mode.stream_setup ||
+         glparamstate.imm_mode.stream_attributes != immediate_attributes())) {
+        setup_immediate_stream(gxmode, emit_count);
+    }
+
+    if (emit_count > 0 && glparamstate.imm_mode.stream_should_draw) {
+        GX_Begin(gxmode.mode, _ogx_arrays_vtxfmt(), emit_count + loop);
+        _ogx_arrays_emit_range(0, emit_count, loop);
+        GX_End();
+    }
+
+    if (end) {
+        if (glparamstate.imm_mode.stream_setup) {
+            if (glparamstate.imm_mode.stream_should_draw)
+                glparamstate.draw_count++;
+            draw_done(false);
+            _ogx_gpu_resources_pop();
+        }
+        return;
+    }
+
+    /* Keep the vertices needed to continue the primitive */
+    if (keep_last > 0) {
+        memmove(vertices + keep_first, vertices + count - keep_last,
+                keep_last * sizeof(VertexData));
+    }
+    glparamstate.imm_mode.current_numverts = keep_first + keep_last;
+    glparamstate.imm_mode.stream_flushed = 1;
+}
+
 void glFrustum(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top,
                GLdouble near, GLdouble far)
 {
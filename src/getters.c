@@ -43,7 +43,10 @@ static const GLubyte gl_null_string[1] = { 0 };
 /* This is not static because we might modify it in place */
 static GLubyte s_extension_string[] =
     "GL_ARB_multitexture "
-    "GL_ARB_vertex_buffer_object ";
+    "GL_ARB_vertex_buffer_object "
+    "GL_OGX_draw_instanced "
+    "GL_OGX_matrix_palette "
+    "GL_OGX_vertex_quantization ";
 
 static int prepare_extension_strings()
 {
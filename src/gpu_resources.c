@@ -71,6 +71,10 @@ static void resources_init(OgxGpuResources *resources)
 
     resources->texmap_first = 0;
     resources->texmap_end = 8;
+
+    /* GX_VTXFMT0 is used for one-off drawings and display lists */
+    resources->vtxfmt_first = 1;
+    resources->vtxfmt_end = GX_MAXVTXFMT;
 }
 
 void _ogx_gpu_resources_init()
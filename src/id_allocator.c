@@ -0,0 +1,69 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include "id_allocator.h"
+
+int _ogx_id_alloc(OgxIdAllocator *ids, int count)
+{
+    int start = ids->first_free, id = start;
+
+    if (count <= 0) return -1;
+
+    while (id - start < count) {
+        if (id >= ids->size) return -1;
+
+        /* The IDs from id to the end of its word */
+        uint32_t taken = ids->words[id / 32] >> (id % 32);
+        int span = 32 - id % 32;
+        if (taken == 0) {
+            id += span;
+            continue;
+        }
+
+        int free_ids = __builtin_ctz(taken);
+        if (id + free_ids - start >= count) break;
+
+        /* Skip the free IDs, which are not enough, and the taken ones */
+        uint32_t free_mask = ~(taken >> free_ids);
+        int taken_ids = free_mask == 0 ? span : __builtin_ctz(free_mask);
+        if (free_ids == 0 && id == ids->first_free) {
+            ids->first_free = id + taken_ids;
+        }
+        id += free_ids + taken_ids;
+        start = id;
+    }
+
+    if (start + count > ids->size) return -1;
+
+    for (id = start; id < start + count; id++) {
+        _ogx_id_take(ids, id);
+    }
+    if (start == ids->first_free) ids->first_free = start + count;
+    return start;
+}
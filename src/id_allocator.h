@@ -0,0 +1,81 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef OPENGX_ID_ALLOCATOR_H
+#define OPENGX_ID_ALLOCATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Keeps track of the names taken in a namespace of GL objects (display lists,
+ * textures, buffers), as a bitmap of IDs from 0 to size - 1. Allocation starts
+ * from the lowest ID which might be free, and skips full words of taken IDs at
+ * once, so that generating objects one after the other costs O(1). */
+typedef struct {
+    uint32_t *words; /* bit set if the ID is taken */
+    int size;
+    int first_free; /* no ID below this one is free */
+} OgxIdAllocator;
+
+/* Defines a static allocator for the given number of IDs */
+#define OGX_ID_ALLOCATOR(name, count) \
+    static uint32_t name##_words[((count) + 31) / 32]; \
+    static OgxIdAllocator name = { name##_words, count, 0 }
+
+/* Takes count contiguous free IDs, and returns the first one; -1 if there is
+ * no such range. */
+int _ogx_id_alloc(OgxIdAllocator *ids, int count);
+
+/* Marks an ID as taken, for objects created with a user-chosen name (as in
+ * glBindTexture() or glNewList()) */
+static inline void _ogx_id_take(OgxIdAllocator *ids, int id)
+{
+    ids->words[id / 32] |= 1u << (id % 32);
+}
+
+static inline void _ogx_id_release(OgxIdAllocator *ids, int id)
+{
+    ids->words[id / 32] &= ~(1u << (id % 32));
+    if (id < ids->first_free) ids->first_free = id;
+}
+
+static inline bool _ogx_id_is_taken(const OgxIdAllocator *ids, int id)
+{
+    return ids->words[id / 32] & (1u << (id % 32));
+}
+
+#ifdef __cplusplus
+} // extern C
+#endif
+
+#endif /* OPENGX_ID_ALLOCATOR_H */
@@ -93,6 +93,66 @@ extern uintptr_t ogx_fast_conv_LA_IA8;
 extern uintptr_t ogx_fast_conv_Intensity_I8;
 extern uintptr_t ogx_fast_conv_Alpha_A8;
 
+/* Draw call statistics, useful to tune the draw batching and culling (enabled
+ * by adding "batch_draws" and "cull_draws" to the OPENGX_FAST_OPS environment
+ * variable). The counters are never reset. */
+typedef struct {
+    /* Number of glDrawArrays() and glDrawElements() calls executed (each
+     * sub-draw of glMultiDrawArrays() and glMultiDrawElements(), and each
+     * instance of an instanced draw, counts as one) */
+    uint32_t draw_calls;
+    /* Number of draw calls which were merged into the previous one */
+    uint32_t merged_draw_calls;
+    /* Number of draw calls skipped because their vertices, read from a VBO,
+     * were all outside of the view frustum */
+    uint32_t culled_draw_calls;
+} OgxBatchStats;
+void ogx_get_batch_stats(OgxBatchStats *stats);
+
+/* GL_OGX_vertex_quantization extension: glBufferQuantizationOGX() (obtained
+ * via ogx_get_proc_address()) sets the maximum absolute error allowed when
+ * converting the float positions, normals and texture coordinates stored in
+ * the buffer bound to target into GX fixed point formats. The tightest format
+ * within the error bound is chosen for each attribute array; 0 (the default)
+ * disables quantization. */
+typedef void (*PFNGLBUFFERQUANTIZATIONOGXPROC)(GLenum target,
+                                               GLfloat max_error);
+
+/* GL_OGX_draw_instanced extension: glDrawArraysInstancedOGX() and
+ * glDrawElementsInstancedOGX() (obtained via ogx_get_proc_address()) draw
+ * the given vertices instancecount times. matrices points to instancecount
+ * 4x4 matrices, in the same format as glMultMatrixf(): each instance is drawn
+ * as if its matrix had been multiplied into the modelview matrix. Up to nine
+ * instances are transformed by the GPU in a single primitive. */
+typedef void (*PFNGLDRAWARRAYSINSTANCEDOGXPROC)(GLenum mode, GLint first,
+                                                GLsizei count,
+                                                GLsizei instancecount,
+                                                const GLfloat *matrices);
+typedef void (*PFNGLDRAWELEMENTSINSTANCEDOGXPROC)(GLenum mode, GLsizei count,
+                                                  GLenum type,
+                                                  const GLvoid *indices,
+                                                  GLsizei instancecount,
+                                                  const GLfloat *matrices);
+
+/* GL_OGX_matrix_palette extension: glMatrixPaletteOGX() sets a palette of up
+ * to ten 4x4 matrices (in the same format as glMultMatrixf(), passing 0 as
+ * count disables the palette), and glMatrixIndexPointerOGX() sets an array of
+ * per-vertex palette indices (GL_UNSIGNED_BYTE or GL_UNSIGNED_SHORT, read from
+ * the bound GL_ARRAY_BUFFER if any; a NULL pointer disables the array). When
+ * both are set, each vertex drawn by glDrawArrays(), glDrawElements() and
+ * their variants is transformed by the modelview matrix multiplied by its
+ * palette matrix, on the GPU. This is not recorded into display lists, and is
+ * ignored by glBegin()/glEnd() and shader programs. */
+typedef void (*PFNGLMATRIXPALETTEOGXPROC)(GLsizei count,
+                                          const GLfloat *matrices);
+typedef void (*PFNGLMATRIXINDEXPOINTEROGXPROC)(GLenum type, GLsizei stride,
+                                               const GLvoid *pointer);
+
+/* Returns the number of bytes of GX display list data owned by the given GL
+ * call list (0 if the list is empty or does not exist). Useful to diagnose
+ * memory usage. */
+uint32_t ogx_call_list_gx_bytes(GLuint list);
+
 typedef enum {
     OGX_STENCIL_NONE = 0,
     /* Don't worry about Z buffer being updated even if a fragment fails the
@@ -138,9 +198,11 @@ typedef struct {
     uint8_t texmtx_end;
     uint8_t texmap_first;
     uint8_t texmap_end;
-    /* We could add the VTXFMT here too, if we decided to reserve them for
-     * specific goals; for the time being, we only use GX_VTXFMT0 and set it up
-     * from scratch every time. */
+    /* Vertex formats used for drawing vertex arrays; opengx caches vertex
+     * layouts in them, so they must not be modified by others. GX_VTXFMT0 is
+     * always set up from scratch before being used. */
+    uint8_t vtxfmt_first;
+    uint8_t vtxfmt_end;
 } OgxGpuResources;
 
 extern OgxGpuResources *ogx_gpu_resources;
@@ -160,6 +222,10 @@ typedef struct _OgxDrawData {
     /* for drawing elements: */
     GLenum type;
     const GLvoid *indices;
+    /* The range of the index values, if known (glDrawRangeElements()) */
+    bool has_index_range;
+    GLuint min_index;
+    GLuint max_index;
 } OgxDrawData;
 
 typedef struct {
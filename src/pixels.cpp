@@ -243,53 +243,41 @@ static int get_pixel_size_in_bits(GLenum format, GLenum type)
     return c->components_per_pixel * type_size * 8;
 }
 
-void _ogx_bytes_to_texture(const void *data, GLenum format, GLenum type,
-                           int width, int height,
-                           void *dst, uint32_t gx_format,
-                           int x, int y, int dstpitch)
+/* The GL_UNPACK_SKIP_ROWS and GL_UNPACK_SKIP_PIXELS can be handled by
+ * modifiying the source data pointer. For bitmaps, the skip_pixels case must
+ * be handled in the reader itself, since we cannot skip partial bytes: in that
+ * case, need_skip_pixels is set to true. */
+static const void *apply_unpack_skip(const void *data,
+                                     GLenum format, GLenum type, int width,
+                                     bool *need_skip_pixels)
 {
-    /* Skip degenerate cases */
-    if (width <= 0 || height <= 0) return;
+    *need_skip_pixels = false;
+    if (glparamstate.unpack_skip_pixels <= 0 &&
+        glparamstate.unpack_skip_rows <= 0) return data;
 
-    /* The GL_UNPACK_SKIP_ROWS and GL_UNPACK_SKIP_PIXELS can be handled here by
-     * modifiying the source data pointer. */
-    bool need_skip_pixels = false;
     int row_length = glparamstate.unpack_row_length > 0 ?
         glparamstate.unpack_row_length : width;
-    if (glparamstate.unpack_skip_pixels > 0 || glparamstate.unpack_skip_rows > 0) {
-        int pixel_size_bits = get_pixel_size_in_bits(format, type);
-        int row_size_bytes = (row_length * pixel_size_bits + 7) / 8;
-        /* For bitmaps, the skip_pixels case is handled in the reader itself,
-         * since we cannot skip partial bytes here. */
-        int skip_pixels = 0;
-        if (pixel_size_bits >= 8) {
-            skip_pixels = glparamstate.unpack_skip_pixels * pixel_size_bits;
-        } else {
-            need_skip_pixels = true;
-        }
-        data = static_cast<const uint8_t*>(data) + skip_pixels +
-            glparamstate.unpack_skip_rows * row_size_bytes;
-    }
-    /* Accelerate the most common transformations by using the specialized
-     * readers. We only do this for some transformations, since every
-     * instantiation of the template takes some space, and the number of
-     * possible combinations is polynomial.
-     */
-    if (type == GL_BYTE || type == GL_UNSIGNED_BYTE || type == GL_FLOAT) {
-        for (int i = 0; i < MAX_FAST_CONVERSIONS; i++) {
-            const FastConversion &c = s_registered_conversions[i];
-            if (c.gl_format == 0) break;
-
-            if (c.gl_format == format && c.gx_format == gx_format) {
-                c.conv.func(data, type, width, height, dst, x, y, dstpitch);
-                return;
-            }
-        }
+    int pixel_size_bits = get_pixel_size_in_bits(format, type);
+    int row_size_bytes = (row_length * pixel_size_bits + 7) / 8;
+    int skip_pixels = 0;
+    if (pixel_size_bits >= 8) {
+        skip_pixels = glparamstate.unpack_skip_pixels * pixel_size_bits;
+    } else {
+        *need_skip_pixels = true;
     }
+    return static_cast<const uint8_t*>(data) + skip_pixels +
+        glparamstate.unpack_skip_rows * row_size_bytes;
+}
 
-    debug(OGX_LOG_TEXTURE,
-          "No fast conversion registered for GL format %04x to GX format %d",
-          format, gx_format);
+static void bytes_to_texture_generic(const void *data,
+                                     GLenum format, GLenum type,
+                                     int width, int height,
+                                     void *dst, uint32_t gx_format,
+                                     int x, int y, int dstpitch,
+                                     bool need_skip_pixels)
+{
+    int row_length = glparamstate.unpack_row_length > 0 ?
+        glparamstate.unpack_row_length : width;
 
     /* Here starts the code for the generic converter. We start by selecting
      * the proper Texel subclass for the given GX texture format, then we
@@ -409,6 +397,55 @@ void _ogx_bytes_to_texture(const void *data, GLenum format, GLenum type,
     }
 }
 
+void _ogx_bytes_to_texture(const void *data, GLenum format, GLenum type,
+                           int width, int height,
+                           void *dst, uint32_t gx_format,
+                           int x, int y, int dstpitch)
+{
+    /* Skip degenerate cases */
+    if (width <= 0 || height <= 0) return;
+
+    bool need_skip_pixels;
+    data = apply_unpack_skip(data, format, type, width, &need_skip_pixels);
+
+    /* Accelerate the most common transformations by using the specialized
+     * readers. We only do this for some transformations, since every
+     * instantiation of the template takes some space, and the number of
+     * possible combinations is polynomial.
+     */
+    if (type == GL_BYTE || type == GL_UNSIGNED_BYTE || type == GL_FLOAT) {
+        for (int i = 0; i < MAX_FAST_CONVERSIONS; i++) {
+            const FastConversion &c = s_registered_conversions[i];
+            if (c.gl_format == 0) break;
+
+            if (c.gl_format == format && c.gx_format == gx_format) {
+                c.conv.func(data, type, width, height, dst, x, y, dstpitch);
+                return;
+            }
+        }
+    }
+
+    debug(OGX_LOG_TEXTURE,
+          "No fast conversion registered for GL format %04x to GX format %d",
+          format, gx_format);
+
+    bytes_to_texture_generic(data, format, type, width, height,
+                             dst, gx_format, x, y, dstpitch, need_skip_pixels);
+}
+
+void _ogx_bytes_to_texture_generic(const void *data, GLenum format, GLenum type,
+                                   int width, int height,
+                                   void *dst, uint32_t gx_format,
+                                   int x, int y, int dstpitch)
+{
+    if (width <= 0 || height <= 0) return;
+
+    bool need_skip_pixels;
+    data = apply_unpack_skip(data, format, type, width, &need_skip_pixels);
+    bytes_to_texture_generic(data, format, type, width, height,
+                             dst, gx_format, x, y, dstpitch, need_skip_pixels);
+}
+
 int _ogx_pitch_for_width(uint32_t gx_format, int width)
 {
     switch (gx_format) {
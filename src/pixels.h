@@ -43,6 +43,12 @@ void _ogx_bytes_to_texture(const void *data, GLenum format, GLenum type,
                            int width, int height,
                            void *dst, uint32_t gx_format,
                            int x, int y, int dstpitch);
+/* Like _ogx_bytes_to_texture(), but never uses the fast converters registered
+ * with ogx_register_tex_conversion(). Useful for benchmarking. */
+void _ogx_bytes_to_texture_generic(const void *data, GLenum format, GLenum type,
+                                   int width, int height,
+                                   void *dst, uint32_t gx_format,
+                                   int x, int y, int dstpitch);
 
 int _ogx_pitch_for_width(uint32_t gx_format, int width);
 uint8_t _ogx_gl_format_to_gx(GLenum format);
@@ -263,6 +263,7 @@ void glBitmap(GLsizei width, GLsizei height,
               GLfloat xmove, GLfloat ymove,
               const GLubyte *bitmap)
 {
+    _ogx_flush_draw_batch();
     if (width < 0 || height < 0) {
         set_error(GL_INVALID_VALUE);
         return;
@@ -447,6 +448,7 @@ struct PixelWriter {
 void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
                   GLenum format, GLenum type, GLvoid *data)
 {
+    _ogx_flush_draw_batch();
     uint8_t gxformat = 0xff;
     const ReadPixelFormat *read_format = NULL;
     ReadPixelFormat stencil_format;
@@ -500,6 +502,7 @@ void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height,
 void glDrawPixels(GLsizei width, GLsizei height, GLenum format, GLenum type,
                   const GLvoid *pixels)
 {
+    _ogx_flush_draw_batch();
     if (width < 0 || height < 0) {
         set_error(GL_INVALID_VALUE);
         return;
@@ -550,6 +553,7 @@ void glDrawPixels(GLsizei width, GLsizei height, GLenum format, GLenum type,
 
 void glCopyPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum type)
 {
+    _ogx_flush_draw_batch();
     if (type != GL_COLOR) {
         warning("glCopyPixels() only implemented for color copies");
         return;
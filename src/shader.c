@@ -32,6 +32,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #define GL_GLEXT_PROTOTYPES
 #define BUILDING_SHADER_CODE
 #include "debug.h"
+#include "id_allocator.h"
 #include "murmurhash3.h"
 #include "shader.h"
 #include "state.h"
@@ -43,8 +44,43 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <malloc.h>
 #include <stdarg.h>
 
+/* Maximum number of programs and shaders existing at the same time */
+#define MAX_SHADER_NAMES 512
+
 OgxShaderState _ogx_shader_state;
 const static OgxProgramProcessor *s_processor = NULL;
+OGX_ID_ALLOCATOR(s_shader_ids, MAX_SHADER_NAMES);
+static struct {
+    void *object;
+    bool is_program;
+} s_shader_names[MAX_SHADER_NAMES];
+
+GLuint _ogx_shader_name_new(void *object, bool is_program)
+{
+    int index = _ogx_id_alloc(&s_shader_ids, 1);
+    if (index < 0) {
+        warning("Could not allocate a name for a shader or program");
+        set_error(GL_OUT_OF_MEMORY);
+        return 0;
+    }
+    s_shader_names[index].object = object;
+    s_shader_names[index].is_program = is_program;
+    return index + 1;
+}
+
+void _ogx_shader_name_delete(GLuint name)
+{
+    if (name == 0 || name > MAX_SHADER_NAMES) return;
+    s_shader_names[name - 1].object = NULL;
+    _ogx_id_release(&s_shader_ids, name - 1);
+}
+
+void *_ogx_shader_name_lookup(GLuint name, bool is_program)
+{
+    if (name == 0 || name > MAX_SHADER_NAMES) return NULL;
+    if (s_shader_names[name - 1].is_program != is_program) return NULL;
+    return s_shader_names[name - 1].object;
+}
 
 /* Get the shader coming after the given one. If s is NULL, returns the first
  * shader in the program.
@@ -297,6 +333,11 @@ GLuint glCreateProgram(void)
     if (!s_processor) return 0;
 
     OgxProgram *p = calloc(1, sizeof(OgxProgram));
+    p->name = _ogx_shader_name_new(p, true);
+    if (p->name == 0) {
+        free(p);
+        return 0;
+    }
     p->next = _ogx_shader_state.programs;
     _ogx_shader_state.programs = p;
     return PROGRAM_TO_INT(p);
@@ -316,6 +357,11 @@ GLuint glCreateShader(GLenum type)
     }
 
     OgxShader *s = calloc(1, sizeof(OgxShader));
+    s->name = _ogx_shader_name_new(s, false);
+    if (s->name == 0) {
+        free(s);
+        return 0;
+    }
     s->next = _ogx_shader_state.shaders;
     _ogx_shader_state.shaders = s;
     s->type = type;
@@ -341,6 +387,10 @@ void glDeleteProgram(GLuint program)
         p->cleanup_user_data_cb(p->user_data);
     }
     free(p->uniform_data_base);
+    OgxProgram **prev = &_ogx_shader_state.programs;
+    while (*prev != p) prev = &(*prev)->next;
+    *prev = p->next;
+    _ogx_shader_name_delete(program);
     free(p);
 }
 
@@ -351,8 +401,9 @@ void glDeleteShader(GLuint shader)
         s->deletion_requested = true;
     } else {
         OgxShader **prev = &_ogx_shader_state.shaders;
-        while (*prev != s) *prev = (*prev)->next;
+        while (*prev != s) prev = &(*prev)->next;
         *prev = s->next;
+        _ogx_shader_name_delete(shader);
         free(s);
     }
 }
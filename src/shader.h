@@ -78,6 +78,7 @@ struct _OgxBoundAttribute {
 
 struct _OgxShader {
     OgxShader *next;
+    GLuint name;
     GLenum type;
     char attach_count;
     unsigned deletion_requested : 1;
@@ -95,6 +96,7 @@ struct _OgxShader {
 
 struct _OgxProgram {
     OgxProgram *next;
+    GLuint name;
     OgxShader *vertex_shader;
     OgxShader *fragment_shader;
     unsigned deletion_requested : 1;
@@ -159,10 +161,17 @@ typedef struct {
 
 typedef struct _OgxVertexAttribState OgxVertexAttribState;
 
-#define PROGRAM_TO_INT(p) ((GLuint)p)
-#define PROGRAM_FROM_INT(p) ((OgxProgram *)p)
-#define SHADER_TO_INT(s) ((GLuint)s)
-#define SHADER_FROM_INT(s) ((OgxShader *)s)
+/* Programs and shaders share the same namespace of GL names; pointers cannot
+ * be used as names, since they don't fit into a GLuint on 64-bit hosts. */
+GLuint _ogx_shader_name_new(void *object, bool is_program);
+void _ogx_shader_name_delete(GLuint name);
+/* Returns NULL if the name is not a valid one for the requested type */
+void *_ogx_shader_name_lookup(GLuint name, bool is_program);
+
+#define PROGRAM_TO_INT(p) ((p)->name)
+#define PROGRAM_FROM_INT(p) ((OgxProgram *)_ogx_shader_name_lookup(p, true))
+#define SHADER_TO_INT(s) ((s)->name)
+#define SHADER_FROM_INT(s) ((OgxShader *)_ogx_shader_name_lookup(s, false))
 
 extern OgxFunctions _ogx_shader_functions;
 extern OgxShaderState _ogx_shader_state;
@@ -0,0 +1,131 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include "skinning.h"
+
+#include "debug.h"
+#include "state.h"
+#include "utils.h"
+#include "vbo.h"
+
+#include <ogc/gx.h>
+#include <string.h>
+
+/* The palette matrices, as given by the client */
+static Mtx s_palette[MAX_PALETTE_MATRICES];
+static int s_palette_count = 0;
+
+/* The per-vertex palette indices */
+static struct {
+    GLenum type;
+    GLsizei stride;
+    VboType vbo;
+    const GLvoid *pointer;
+} s_indices;
+
+bool _ogx_skinning_enabled()
+{
+    /* The indices refer to the client arrays, not to the vertices sent by
+     * glEnd() */
+    return s_palette_count > 0 && (s_indices.pointer || s_indices.vbo) &&
+        !glparamstate.current_program && !glparamstate.imm_mode.in_gl_begin;
+}
+
+OgxDrawFlags _ogx_skinning_setup_draw()
+{
+    static uint8_t pnmtx[MAX_PALETTE_MATRICES];
+
+    if (!_ogx_skinning_enabled()) return OGX_DRAW_FLAG_NONE;
+
+    /* The first matrix goes into GX_PNMTX0 (normally holding the modelview
+     * matrix), the others into the free position matrices */
+    int count = s_palette_count;
+    int free_slots = ogx_gpu_resources->pnmtx_end -
+        ogx_gpu_resources->pnmtx_first;
+    if (count > free_slots + 1) {
+        warning("Only %d palette matrices are available", free_slots + 1);
+        count = free_slots + 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int slot = i == 0 ? 0 : ogx_gpu_resources->pnmtx_first + i - 1;
+        pnmtx[i] = GX_PNMTX0 + slot * 3;
+
+        Mtx mv;
+        guMtxConcat(glparamstate.modelview_matrix, s_palette[i], mv);
+        GX_LoadPosMtxImm(mv, pnmtx[i]);
+        if (glparamstate.lighting.enabled) {
+            Mtx mvinverse, normalm;
+            guMtxInverse(mv, mvinverse);
+            guMtxTranspose(mvinverse, normalm);
+            GX_LoadNrmMtxImm(normalm, pnmtx[i]);
+        }
+    }
+    /* GX_PNMTX0 must be reloaded by the next draw */
+    glparamstate.dirty.bits.dirty_matrices = 1;
+
+    const GLvoid *indices = s_indices.vbo ?
+        _ogx_vbo_get_data(s_indices.vbo, s_indices.pointer) :
+        s_indices.pointer;
+    _ogx_arrays_set_matrix_palette(indices, s_indices.type, s_indices.stride,
+                                   pnmtx, count);
+    return OGX_DRAW_FLAG_MATRIX_INDEX;
+}
+
+void glMatrixPaletteOGX(GLsizei count, const GLfloat *matrices)
+{
+    if (count < 0 || count > MAX_PALETTE_MATRICES) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        gl_matrix_to_gx(matrices + i * 16, s_palette[i]);
+    }
+    s_palette_count = count;
+}
+
+void glMatrixIndexPointerOGX(GLenum type, GLsizei stride,
+                             const GLvoid *pointer)
+{
+    if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT) {
+        set_error(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (stride < 0) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    s_indices.type = type;
+    s_indices.stride = stride;
+    s_indices.vbo = glparamstate.bound_vbo_array;
+    s_indices.pointer = pointer;
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef OPENGX_SKINNING_H
+#define OPENGX_SKINNING_H
+
+#include "arrays.h"
+
+#include <GL/gl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of matrices in the palette: GX has ten position matrices */
+#define MAX_PALETTE_MATRICES 10
+
+/* Whether draws are transformed by the matrix palette */
+bool _ogx_skinning_enabled(void);
+/* If skinning is enabled, loads the palette matrices (combined with the
+ * modelview matrix) into the GX position matrices, and sets up the
+ * per-vertex matrix indices; returns the flags to be passed to
+ * _ogx_arrays_setup_draw(). */
+OgxDrawFlags _ogx_skinning_setup_draw(void);
+
+/* GL_OGX_matrix_palette extension */
+void glMatrixPaletteOGX(GLsizei count, const GLfloat *matrices);
+void glMatrixIndexPointerOGX(GLenum type, GLsizei stride,
+                             const GLvoid *pointer);
+
+#ifdef __cplusplus
+} // extern C
+#endif
+
+#endif /* OPENGX_SKINNING_H */
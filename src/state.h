@@ -78,6 +78,27 @@ typedef enum {
     OGX_HINT_NONE = 0,
     /* Enables fast (but wrong) GPU-accelerated GL_SPHERE_MAP */
     OGX_HINT_FAST_SPHERE_MAP = 1 << 0,
+    /* Lets the GPU read client-side arrays directly in glDrawElements(); this
+     * is only correct if the client does not modify the array data until the
+     * frame has been rendered. */
+    OGX_HINT_INDEXED_CLIENT_ARRAYS = 1 << 1,
+    /* Merges consecutive glDrawArrays() calls sharing the same state into a
+     * single GX primitive (see _ogx_flush_draw_batch()) */
+    OGX_HINT_BATCH_DRAWS = 1 << 2,
+    /* Skips the draws whose VBO positions lie entirely outside of the view
+     * frustum (see _ogx_vbo_get_bounds()) */
+    OGX_HINT_CULL_DRAWS = 1 << 3,
+    /* Records the render state (TEV, lighting, textures, blending...) of the
+     * draws compiled into a display list together with the geometry: the
+     * state set by the list itself, applied over the one in effect at
+     * glEndList() (or at the draw, in GL_COMPILE_AND_EXECUTE mode). This is
+     * only correct if the list is always called with the same outer state.
+     * The draws following a nested glCallList() are not baked. */
+    OGX_HINT_BAKE_CALL_LISTS = 1 << 4,
+    /* Copies the commands of the lists called by a display list into the
+     * caller when it is compiled, trading memory for faster execution of
+     * nested lists */
+    OGX_HINT_INLINE_CALL_LISTS = 1 << 5,
 } OgxHints;
 
 typedef enum {
@@ -101,6 +122,8 @@ typedef float ClipPlane[4];
 typedef struct gltexture_
 {
     GXTexObj texobj;
+    /* Sync token sent after the last draw which might have used the texture */
+    uint16_t last_sync_token_sent;
 } gltexture_;
 
 typedef enum {
@@ -252,6 +275,12 @@ typedef struct glparams_
         unsigned has_color : 1;
         unsigned has_normal : 1;
         unsigned has_texcoord : MAX_TEXTURE_UNITS;
+        /* See _ogx_immediate_flush() */
+        unsigned streaming : 1;
+        unsigned stream_setup : 1;
+        unsigned stream_should_draw : 1;
+        unsigned stream_flushed : 1;
+        uint8_t stream_attributes;
     } imm_mode;
 
     union dirty_union
@@ -362,6 +391,25 @@ void _ogx_scene_save_from_efb(void);
 void _ogx_scene_load_into_efb(void);
 void _ogx_update_matrices(void);
 void _ogx_update_matrices_fixed_pipeline(void);
+/* Immediate mode streaming: when possible, the vertices specified between
+ * glBegin() and glEnd() are sent to the GPU every IMM_CHUNK_SIZE vertices,
+ * instead of being accumulated until glEnd(). The chunk size must be a
+ * multiple of the number of vertices of the independent primitive types (1, 2,
+ * 3 and 4), and even, so that triangle strips keep their winding across
+ * chunks. */
+#define IMM_CHUNK_SIZE 48
+void _ogx_immediate_flush(bool end);
+
+/* GL_OGX_draw_instanced extension */
+void glDrawArraysInstancedOGX(GLenum mode, GLint first, GLsizei count,
+                              GLsizei instancecount, const GLfloat *matrices);
+void glDrawElementsInstancedOGX(GLenum mode, GLsizei count, GLenum type,
+                                const GLvoid *indices, GLsizei instancecount,
+                                const GLfloat *matrices);
+/* Sends the batched draws (if any) to the GPU. This must be called before
+ * any operation which changes the GX state directly or reads the
+ * framebuffer. */
+void _ogx_flush_draw_batch(void);
 
 #ifdef __cplusplus
 } // extern C
@@ -34,6 +34,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "call_lists.h"
 #include "debug.h"
+#include "id_allocator.h"
 #include "image_DXT.h"
 #include "pixels.h"
 #include "state.h"
@@ -41,12 +42,93 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <malloc.h>
 
+typedef struct _RetiredTexels RetiredTexels;
+
+/* Texture storage which has been replaced while the GPU might still be
+ * reading from it; it's freed once the sync token has been received. */
+struct _RetiredTexels {
+    void *texels;
+    uint16_t last_sync_token_sent;
+    RetiredTexels *next;
+};
+
+static RetiredTexels *s_retired_texels = NULL;
+OGX_ID_ALLOCATOR(s_texture_ids, _MAX_GL_TEX);
+/* Token assigned to the textures used by the latest draws; it is only sent to
+ * the GPU when someone needs to wait for them, or when another token is sent
+ * anyway. */
+static uint16_t s_pending_token = 0;
+
 static inline int curr_tex()
 {
     int unit = glparamstate.active_texture;
     return glparamstate.texture_unit[unit].glcurtex;
 }
 
+static void send_pending_token()
+{
+    if (s_pending_token > _ogx_draw_sync_token) {
+        send_draw_sync_token();
+    }
+}
+
+static bool texture_is_in_use(const gltexture_ *texture)
+{
+    uint16_t token = texture->last_sync_token_sent;
+    if (token == s_pending_token) send_pending_token();
+    /* The token counter is reset on every frame: a token higher than the last
+     * one sent comes from a previous frame, which has been completed. */
+    return token > _ogx_draw_sync_token_received &&
+        token <= _ogx_draw_sync_token;
+}
+
+static void wait_texture_not_in_use(gltexture_ *texture)
+{
+    if (texture_is_in_use(texture)) {
+        while (GX_GetDrawSync() < texture->last_sync_token_sent);
+    }
+    texture->last_sync_token_sent = 0;
+}
+
+static void check_releasable_retired_texels(bool release_all)
+{
+    RetiredTexels **prev_ptr = &s_retired_texels;
+    RetiredTexels *retired = s_retired_texels;
+    while (retired) {
+        RetiredTexels *next = retired->next;
+        if (release_all ||
+            _ogx_draw_sync_token_received >= retired->last_sync_token_sent) {
+            free(retired->texels);
+            free(retired);
+            *prev_ptr = next;
+        } else {
+            prev_ptr = &retired->next;
+        }
+        retired = next;
+    }
+}
+
+/* Frees the given texels (which must belong to the given texture) as soon as
+ * the GPU is done with them. */
+static void release_texels(gltexture_ *texture, void *texels)
+{
+    RetiredTexels *retired = NULL;
+    if (texture_is_in_use(texture)) {
+        retired = malloc(sizeof(RetiredTexels));
+        if (!retired) wait_texture_not_in_use(texture);
+    }
+
+    if (retired) {
+        retired->texels = texels;
+        retired->last_sync_token_sent = texture->last_sync_token_sent;
+        retired->next = s_retired_texels;
+        s_retired_texels = retired;
+    } else {
+        free(texels);
+    }
+    texture->last_sync_token_sent = 0;
+}
+
 static uint32_t calc_memory(int w, int h, uint32_t format)
 {
     return GX_GetTexBufferSize(w, h, format, GX_FALSE, 0);
@@ -449,8 +531,10 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei widt
     if (target != GL_TEXTURE_2D)
         return; // FIXME Implement non 2D textures
 
-    GX_DrawDone(); // Very ugly, we should have a list of used textures and only wait if we are using the curr tex.
-                   // This way we are sure that we are not modifying a texture which is being drawn
+    _ogx_flush_draw_batch();
+
+    if (s_retired_texels)
+        check_releasable_retired_texels(false);
 
     gltexture_ *currtex = &texture_list[tex_id];
     GXTexObj *texobj = &currtex->texobj;
@@ -472,6 +556,7 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei widt
 
     OgxTextureInfo ti;
     texture_get_info(texobj, &ti);
+    uint8_t old_format = ti.format;
     ti.format = gx_format;
     /* GX_TF_A8 is not supported by Dolphin and it's not properly handed by
      * a real Wii either. */
@@ -487,7 +572,7 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei widt
     // If the specified level is zero, create a onelevel texture to save memory
     if (wi != ti.width || he != ti.height) {
         if (ti.texels != 0)
-            free(ti.texels);
+            release_texels(currtex, ti.texels);
         uint32_t required_size;
         if (level == 0) {
             required_size = calc_memory(width, height, ti.format);
@@ -506,6 +591,21 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei widt
         ti.maxlevel = level;
         ti.width = wi;
         ti.height = he;
+    } else if (texture_is_in_use(currtex)) {
+        /* The GPU might still be reading from the texture: rather than waiting
+         * for it, move the texture to a new storage. The old contents need to
+         * be preserved only if there are other levels. */
+        uint32_t size = onelevel ?
+            calc_memory(ti.width, ti.height, old_format) :
+            calc_tex_size(ti.width, ti.height, old_format);
+        void *texels = memalign(32, size);
+        if (texels) {
+            if (!onelevel || level != 0) memcpy(texels, ti.texels, size);
+            release_texels(currtex, ti.texels);
+            ti.texels = texels;
+        } else {
+            wait_texture_not_in_use(currtex);
+        }
     }
     if (ti.maxlevel < level)
         ti.maxlevel = level;
@@ -528,7 +628,7 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei widt
         }
 
         memcpy(ti.texels, oldbuf, tsize);
-        free(oldbuf);
+        release_texels(currtex, oldbuf);
     }
 
     if (data) {
@@ -558,6 +658,8 @@ void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
         return;
     }
 
+    _ogx_flush_draw_batch();
+
     gltexture_ *currtex = &texture_list[tex_id];
 
     OgxTextureInfo ti;
@@ -584,6 +686,7 @@ void glBindTexture(GLenum target, GLuint texture)
 
     if (!TEXTURE_IS_RESERVED(texture_list[texture])) {
         TEXTURE_RESERVE(texture_list[texture]);
+        _ogx_id_take(&s_texture_ids, texture);
     }
 
     /* We don't load the texture now, since its texels might not have been
@@ -604,29 +707,73 @@ void glTexImage3D(GLenum target, GLint level, GLint internalFormat,
 
 void glDeleteTextures(GLsizei n, const GLuint *textures)
 {
+    _ogx_flush_draw_batch();
     const GLuint *texlist = textures;
-    GX_DrawDone();
     while (n-- > 0) {
         int i = *texlist++;
         if (i > 0 && i < _MAX_GL_TEX) {
             void *data = GX_GetTexObjData(&texture_list[i].texobj);
             if (data != 0)
-                free(MEM_PHYSICAL_TO_K0(data));
+                release_texels(&texture_list[i], MEM_PHYSICAL_TO_K0(data));
             memset(&texture_list[i], 0, sizeof(texture_list[i]));
+            _ogx_id_release(&s_texture_ids, i);
         }
     }
 }
 
+unsigned _ogx_textures_get_used(GLuint *textures)
+{
+    /* Shader programs can sample any bound texture */
+    unsigned units = glparamstate.current_program ?
+        (1 << MAX_TEXTURE_UNITS) - 1 : glparamstate.texture_enabled;
+    unsigned used = 0;
+    for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        if (!(units & (1 << unit))) continue;
+        int tex = glparamstate.texture_unit[unit].glcurtex;
+        if (!TEXTURE_IS_USED(texture_list[tex])) continue;
+        textures[unit] = tex;
+        used |= 1 << unit;
+    }
+    return used;
+}
+
+void _ogx_textures_mark_in_use(unsigned units, const GLuint *textures)
+{
+    if (!units) return;
+
+    /* Any token sent after this draw will do: if the last one we handed out
+     * has not been sent yet, the textures can share it. */
+    if (s_pending_token <= _ogx_draw_sync_token) {
+        s_pending_token = _ogx_draw_sync_token + 1;
+    }
+    for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        if (!(units & (1 << unit))) continue;
+        texture_list[textures[unit]].last_sync_token_sent = s_pending_token;
+    }
+}
+
+void _ogx_textures_set_in_use()
+{
+    GLuint textures[MAX_TEXTURE_UNITS];
+    unsigned units = _ogx_textures_get_used(textures);
+    _ogx_textures_mark_in_use(units, textures);
+}
+
+void _ogx_textures_clear_retired()
+{
+    /* The token counter has just been reset */
+    s_pending_token = 0;
+    check_releasable_retired_texels(true);
+}
+
 void glGenTextures(GLsizei n, GLuint *textures)
 {
     GLuint *texlist = textures;
-    int i;
-    for (i = 0; i < _MAX_GL_TEX && n > 0; i++) {
-        if (!TEXTURE_IS_RESERVED(texture_list[i])) {
-            TEXTURE_RESERVE(texture_list[i]);
-            *texlist++ = i;
-            n--;
-        }
+    for (; n > 0; n--) {
+        int i = _ogx_id_alloc(&s_texture_ids, 1);
+        if (i < 0) break;
+        TEXTURE_RESERVE(texture_list[i]);
+        *texlist++ = i;
     }
 
     if (n > 0) {
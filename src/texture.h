@@ -79,6 +79,17 @@ typedef struct {
 bool _ogx_texture_get_info(GLuint texture_name, OgxTextureInfo *info);
 bool _ogx_texture_get_texobj(GLuint texture_name, GXTexObj *texobj);
 
+/* To be called after a draw operation: marks the textures bound to the texture
+ * units as being in use by the GPU. */
+void _ogx_textures_set_in_use(void);
+/* The two halves of _ogx_textures_set_in_use(), for draws which are sent to
+ * the GPU later: stores into textures (indexed by unit) the names of the
+ * textures the draw samples, and returns the mask of the units using them. */
+unsigned _ogx_textures_get_used(GLuint *textures);
+void _ogx_textures_mark_in_use(unsigned units, const GLuint *textures);
+/* Frees the storage of re-uploaded textures which was still in use */
+void _ogx_textures_clear_retired(void);
+
 #ifdef __cplusplus
 } // extern C
 #endif
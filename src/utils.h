@@ -43,6 +43,9 @@ POSSIBILITY OF SUCH DAMAGE.
 extern "C" {
 #endif
 
+/* Round n up to a multiple of align, which must be a power of two */
+#define ROUND_UP(n, align) (((n) + (align) - 1) & ~((align) - 1))
+
 static inline float clampf_01(float n)
 {
     if (n > 1.0f)
@@ -270,6 +273,7 @@ static inline int read_index(const GLvoid *indices, GLenum type, int i)
     case GL_UNSIGNED_INT:
         return ((uint32_t*)indices)[i];
     }
+    return 0;
 }
 
 static inline void set_gx_mtx_rowv(int row, Mtx m, const float *values)
@@ -29,19 +29,64 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include "vbo.h"
+
 #include "debug.h"
+#include "id_allocator.h"
 #include "state.h"
 #include "utils.h"
 
 #include <malloc.h>
 
 typedef struct _VertexBuffer VertexBuffer;
+typedef struct _ShadowBuffer ShadowBuffer;
+typedef struct _BoundsCache BoundsCache;
+typedef struct _EdgesCache EdgesCache;
+
+/* A copy of some attribute data of a VBO, converted into a format that GX can
+ * read from an array. */
+struct _ShadowBuffer {
+    ShadowBuffer *next;
+    OgxVboShadowKey key;
+    OgxVboShadowFormat format;
+
+    _Alignas(32) uint8_t data[0];
+};
+
+/* The bounding box of a range of positions; see _ogx_vbo_get_bounds() */
+struct _BoundsCache {
+    BoundsCache *next;
+    OgxVboBoundsKey key;
+    OgxVboBounds bounds;
+};
+
+/* Maximum number of bounding boxes cached for a VBO; the least recently used
+ * ones are dropped */
+#define MAX_BOUNDS_PER_VBO 16
+
+/* The wireframe edges of a primitive drawn from the indices stored in the VBO;
+ * see _ogx_vbo_get_edges() */
+struct _EdgesCache {
+    EdgesCache *next;
+    uintptr_t offset;
+    GLenum mode;
+    GLenum type;
+    int count;
+    OgxEdgeList edges;
+};
+
+/* Like MAX_BOUNDS_PER_VBO, for the edge lists */
+#define MAX_EDGES_PER_VBO 4
 
 struct _VertexBuffer {
     size_t size;
     unsigned mapped : 1;
     uint16_t last_sync_token_sent;
+    float max_error; /* See glBufferQuantizationOGX() */
     VertexBuffer *next_unbound;
+    ShadowBuffer *shadows;
+    BoundsCache *bounds;
+    EdgesCache *edges;
 
     /* The buffer data are stored in the same memory block at the end of this
      * struct */
@@ -52,6 +97,7 @@ struct _VertexBuffer {
                         increasing this! */
 
 static VertexBuffer *s_buffers[MAX_VBOS];
+OGX_ID_ALLOCATOR(s_buffer_ids, MAX_VBOS);
 /* List of unbound buffers; we can free them once their sync token has been
  * received */
 static VertexBuffer *s_unbound_buffers = NULL;
@@ -93,6 +139,62 @@ static int get_index_for_target(GLenum target)
     return active_vbo - 1;
 }
 
+static void free_shadows(VertexBuffer *buffer)
+{
+    ShadowBuffer *shadow = buffer->shadows;
+    while (shadow) {
+        ShadowBuffer *next = shadow->next;
+        free(shadow);
+        shadow = next;
+    }
+    buffer->shadows = NULL;
+}
+
+/* Called when the buffer contents have changed */
+static void invalidate_shadows(VertexBuffer *buffer)
+{
+    if (!buffer->shadows) return;
+
+    if (buffer->last_sync_token_sent > _ogx_draw_sync_token_received) {
+        /* The GPU might still be reading the shadow buffers */
+        while (GX_GetDrawSync() < buffer->last_sync_token_sent);
+        buffer->last_sync_token_sent = 0;
+    }
+    free_shadows(buffer);
+    glparamstate.dirty.bits.dirty_attributes = 1;
+}
+
+static void free_bounds(VertexBuffer *buffer)
+{
+    BoundsCache *cache = buffer->bounds;
+    while (cache) {
+        BoundsCache *next = cache->next;
+        free(cache);
+        cache = next;
+    }
+    buffer->bounds = NULL;
+}
+
+static void free_edges(VertexBuffer *buffer)
+{
+    EdgesCache *cache = buffer->edges;
+    while (cache) {
+        EdgesCache *next = cache->next;
+        _ogx_wireframe_free_edges(&cache->edges);
+        free(cache);
+        cache = next;
+    }
+    buffer->edges = NULL;
+}
+
+static void free_buffer(VertexBuffer *buffer)
+{
+    free_shadows(buffer);
+    free_bounds(buffer);
+    free_edges(buffer);
+    free(buffer);
+}
+
 static void check_releasable_unbound_buffers(bool delete_all)
 {
     VertexBuffer **prev_ptr = &s_unbound_buffers;
@@ -102,7 +204,7 @@ static void check_releasable_unbound_buffers(bool delete_all)
         if (delete_all ||
             _ogx_draw_sync_token_received >= buffer->last_sync_token_sent) {
             /* Buffer is done, we can release it */
-            free(buffer);
+            free_buffer(buffer);
             *prev_ptr = next;
         } else {
             prev_ptr = &buffer->next_unbound;
@@ -129,9 +231,10 @@ void glDeleteBuffers(GLsizei n, const GLuint *buffers)
     GX_DrawDone();
     while (n-- > 0) {
         int i = *vbolist++ - 1;
-        if (i >= 0 && i < MAX_VBOS && VBO_IS_USED(i)) {
-            free(s_buffers[i]);
+        if (i >= 0 && i < MAX_VBOS && VBO_IS_RESERVED_OR_USED(i)) {
+            if (VBO_IS_USED(i)) free_buffer(s_buffers[i]);
             s_buffers[i] = NULL;
+            _ogx_id_release(&s_buffer_ids, i);
         }
     }
 }
@@ -140,12 +243,11 @@ void glGenBuffers(GLsizei n, GLuint *buffers)
 {
     GLuint *vbolist = buffers;
     int reserved = 0;
-    for (int i = 0; i < MAX_VBOS && reserved < n; i++) {
-        if (!VBO_IS_RESERVED_OR_USED(i)) {
-            VBO_RESERVE(i);
-            *vbolist++ = i + 1;
-            reserved++;
-        }
+    for (; reserved < n; reserved++) {
+        int i = _ogx_id_alloc(&s_buffer_ids, 1);
+        if (i < 0) break;
+        VBO_RESERVE(i);
+        *vbolist++ = i + 1;
     }
 
     if (reserved < n) {
@@ -154,6 +256,7 @@ void glGenBuffers(GLsizei n, GLuint *buffers)
         /* Unreserve the elements that we reserved just now */
         for (int i = 0; i < reserved; i++) {
             s_buffers[buffers[i] - 1] = NULL;
+            _ogx_id_release(&s_buffer_ids, buffers[i] - 1);
         }
     }
 }
@@ -184,26 +287,39 @@ static void set_buffer_data(GLenum target, GLintptr offset, GLsizeiptr size,
         if (s_unbound_buffers)
             check_releasable_unbound_buffers(false);
 
+        /* The quantization setting survives reallocations */
+        float max_error = 0.0f;
         if (buffer && buffer != RESERVED_PTR) {
+            max_error = buffer->max_error;
             if (buffer->last_sync_token_sent > _ogx_draw_sync_token_received) {
                 /* Buffer is still in use by the GPU, we can't free it right
                  * now */
                 move_to_unbound_list(buffer);
             } else {
-                free(buffer);
+                free_buffer(buffer);
             }
         }
-        size = (size + 31) / 32 * 32;
-        buffer = s_buffers[index] = memalign(32, sizeof(VertexBuffer) + size);
+        size_t alloc_size = ROUND_UP(size, 32);
+        buffer = s_buffers[index] =
+            memalign(32, sizeof(VertexBuffer) + alloc_size);
         if (!buffer) {
             warning("Out of memory allocating a VBO");
             set_error(GL_OUT_OF_MEMORY);
+            /* The name stays valid, though without a data store */
+            VBO_RESERVE(index);
+            _ogx_id_take(&s_buffer_ids, index);
             return;
         }
+        /* The name might have never been returned by glGenBuffers() */
+        _ogx_id_take(&s_buffer_ids, index);
         buffer->size = size;
         buffer->mapped = false;
         buffer->last_sync_token_sent = 0;
+        buffer->max_error = max_error;
         buffer->next_unbound = NULL;
+        buffer->shadows = NULL;
+        buffer->bounds = NULL;
+        buffer->edges = NULL;
         glparamstate.dirty.bits.dirty_attributes = 1;
     }
 
@@ -212,6 +328,9 @@ static void set_buffer_data(GLenum target, GLintptr offset, GLsizeiptr size,
         return;
     }
     if (data) {
+        invalidate_shadows(buffer);
+        free_bounds(buffer);
+        free_edges(buffer);
         if (buffer->last_sync_token_sent != 0) {
             /* We must wait for the draw operation to complete */
             while (GX_GetDrawSync() < buffer->last_sync_token_sent);
@@ -277,7 +396,11 @@ GLboolean glUnmapBuffer(GLenum target)
         return GL_FALSE;
     }
 
+    buffer->mapped = false;
     DCStoreRangeNoSync(buffer->data, buffer->size);
+    invalidate_shadows(buffer);
+    free_bounds(buffer);
+    free_edges(buffer);
     return GL_TRUE;
 }
 
@@ -316,9 +439,37 @@ void glGetBufferPointerv(GLenum target, GLenum pname, void **params)
     *params = buffer->mapped ? buffer->data : NULL;
 }
 
+void glBufferQuantizationOGX(GLenum target, GLfloat max_error)
+{
+    int index = get_index_for_target(target);
+    if (index < 0) return;
+
+    if (!VBO_IS_USED(index)) {
+        set_error(GL_INVALID_OPERATION);
+        return;
+    }
+
+    if (max_error < 0.0f) {
+        set_error(GL_INVALID_VALUE);
+        return;
+    }
+
+    VertexBuffer *buffer = s_buffers[index];
+    if (max_error == buffer->max_error) return;
+
+    invalidate_shadows(buffer);
+    buffer->max_error = max_error;
+    glparamstate.dirty.bits.dirty_attributes = 1;
+}
+
+float _ogx_vbo_get_max_error(VboType vbo)
+{
+    return s_buffers[vbo - 1]->max_error;
+}
+
 void *_ogx_vbo_get_data(VboType vbo, const void *offset)
 {
-    return s_buffers[vbo - 1]->data + (int)offset;
+    return s_buffers[vbo - 1]->data + (intptr_t)offset;
 }
 
 void _ogx_vbo_set_in_use(VboType vbo)
@@ -332,3 +483,206 @@ void _ogx_vbo_clear_unbound_buffers()
 {
     check_releasable_unbound_buffers(true);
 }
+
+static bool shadow_key_equal(const OgxVboShadowKey *a,
+                             const OgxVboShadowKey *b)
+{
+    return a->offset == b->offset && a->stride == b->stride &&
+        a->type == b->type && a->size == b->size &&
+        a->attribute == b->attribute && a->max_error == b->max_error;
+}
+
+void *_ogx_vbo_get_shadow_data(VboType vbo, const OgxVboShadowKey *key,
+                               int src_elem_size, OgxVboShadowFormat *format,
+                               OgxVboConvertFunc convert)
+{
+    VertexBuffer *buffer = s_buffers[vbo - 1];
+    for (ShadowBuffer *shadow = buffer->shadows; shadow; shadow = shadow->next) {
+        if (shadow_key_equal(&shadow->key, key)) {
+            *format = shadow->format;
+            return shadow->data;
+        }
+    }
+
+    /* Convert all the elements from the offset up to the end of the buffer */
+    int count = 0;
+    if (key->offset + src_elem_size <= buffer->size) {
+        count = (buffer->size - key->offset - src_elem_size) / key->stride + 1;
+    }
+    if (count == 0) return NULL;
+
+    const void *src = buffer->data + key->offset;
+    convert(NULL, src, count, key, format);
+    size_t size = ROUND_UP(count * format->stride, 32);
+    ShadowBuffer *shadow = memalign(32, sizeof(ShadowBuffer) + size);
+    if (!shadow) {
+        warning("Out of memory allocating a VBO shadow buffer");
+        return NULL;
+    }
+    shadow->key = *key;
+    shadow->format = *format;
+    convert(shadow->data, src, count, key, format);
+    DCStoreRangeNoSync(shadow->data, size);
+    debug(OGX_LOG_VBO, "Created shadow for VBO %d (%d elements, %d bytes each)",
+          vbo, count, format->stride);
+
+    shadow->next = buffer->shadows;
+    buffer->shadows = shadow;
+    return shadow->data;
+}
+
+static bool bounds_key_equal(const OgxVboBoundsKey *a,
+                             const OgxVboBoundsKey *b)
+{
+    return a->offset == b->offset && a->stride == b->stride &&
+        a->type == b->type && a->size == b->size &&
+        a->first == b->first && a->count == b->count;
+}
+
+static inline float read_component(const uint8_t *ptr, GLenum type)
+{
+    switch (type) {
+    case GL_BYTE: return *(const int8_t *)ptr;
+    case GL_UNSIGNED_BYTE: return *ptr;
+    case GL_SHORT: return *(const int16_t *)ptr;
+    case GL_UNSIGNED_SHORT: return *(const uint16_t *)ptr;
+    case GL_INT: return *(const int32_t *)ptr;
+    case GL_UNSIGNED_INT: return *(const uint32_t *)ptr;
+    case GL_DOUBLE: return *(const double *)ptr;
+    default: return *(const float *)ptr;
+    }
+}
+
+static bool compute_bounds(const VertexBuffer *buffer,
+                           const OgxVboBoundsKey *key, OgxVboBounds *bounds)
+{
+    int component_size = sizeof_gl_type(key->type);
+    int elem_size = component_size * key->size;
+    if (elem_size == 0 || key->size > 3) return false;
+
+    int stride = key->stride > 0 ? key->stride : elem_size;
+    uintptr_t start = key->offset + key->first * stride;
+    if (key->first < 0 || start + elem_size > buffer->size) return false;
+
+    int count = (buffer->size - start - elem_size) / stride + 1;
+    if (key->count >= 0 && key->count < count) count = key->count;
+    if (count <= 0) return false;
+
+    /* Missing components are 0 */
+    for (int c = 0; c < 3; c++) {
+        bounds->min[c] = bounds->max[c] = 0.0f;
+    }
+    const uint8_t *data = buffer->data + start;
+    for (int c = 0; c < key->size; c++) {
+        float v = read_component(data + c * component_size, key->type);
+        bounds->min[c] = bounds->max[c] = v;
+    }
+    for (int i = 1; i < count; i++) {
+        data += stride;
+        for (int c = 0; c < key->size; c++) {
+            float v = read_component(data + c * component_size, key->type);
+            if (v < bounds->min[c]) bounds->min[c] = v;
+            else if (v > bounds->max[c]) bounds->max[c] = v;
+        }
+    }
+    return true;
+}
+
+bool _ogx_vbo_get_bounds(VboType vbo, const OgxVboBoundsKey *key,
+                         OgxVboBounds *bounds)
+{
+    VertexBuffer *buffer = s_buffers[vbo - 1];
+    BoundsCache **prev_ptr = &buffer->bounds;
+    int n = 0;
+    for (BoundsCache *cache = buffer->bounds; cache; cache = cache->next) {
+        if (bounds_key_equal(&cache->key, key)) {
+            /* Move it to the front of the list */
+            *prev_ptr = cache->next;
+            cache->next = buffer->bounds;
+            buffer->bounds = cache;
+            *bounds = cache->bounds;
+            return true;
+        }
+        if (++n == MAX_BOUNDS_PER_VBO) {
+            /* Drop the least recently used entry */
+            free(cache);
+            *prev_ptr = NULL;
+            break;
+        }
+        prev_ptr = &cache->next;
+    }
+
+    if (!compute_bounds(buffer, key, bounds)) return false;
+
+    BoundsCache *cache = malloc(sizeof(BoundsCache));
+    if (cache) {
+        cache->key = *key;
+        cache->bounds = *bounds;
+        cache->next = buffer->bounds;
+        buffer->bounds = cache;
+    }
+    return true;
+}
+
+bool _ogx_vbo_get_index_range(VboType vbo, const void *offset, GLenum type,
+                              int count, GLuint *min_index, GLuint *max_index)
+{
+    /* An index array is just like an array of one-component positions */
+    OgxVboBoundsKey key = { (uintptr_t)offset, 0, type, 1, 0, count };
+    OgxVboBounds bounds;
+    if (!_ogx_vbo_get_bounds(vbo, &key, &bounds)) return false;
+
+    /* Larger values cannot be exactly represented by a float */
+    if (bounds.max[0] >= (1 << 24)) return false;
+
+    *min_index = bounds.min[0];
+    *max_index = bounds.max[0];
+    return true;
+}
+
+const OgxEdgeList *_ogx_vbo_get_edges(VboType vbo, GLenum mode,
+                                      const void *offset, GLenum type,
+                                      int count)
+{
+    VertexBuffer *buffer = s_buffers[vbo - 1];
+    EdgesCache **prev_ptr = &buffer->edges;
+    int n = 0;
+    for (EdgesCache *cache = buffer->edges; cache; cache = cache->next) {
+        if (cache->offset == (uintptr_t)offset && cache->mode == mode &&
+            cache->type == type && cache->count == count) {
+            /* Move it to the front of the list */
+            *prev_ptr = cache->next;
+            cache->next = buffer->edges;
+            buffer->edges = cache;
+            return &cache->edges;
+        }
+        if (++n == MAX_EDGES_PER_VBO) {
+            /* Drop the least recently used entry */
+            _ogx_wireframe_free_edges(&cache->edges);
+            free(cache);
+            *prev_ptr = NULL;
+            break;
+        }
+        prev_ptr = &cache->next;
+    }
+
+    if ((uintptr_t)offset + count * sizeof_gl_type(type) > buffer->size)
+        return NULL;
+
+    EdgesCache *cache = malloc(sizeof(EdgesCache));
+    if (!cache) return NULL;
+    if (!_ogx_wireframe_build_edges(mode, buffer->data + (uintptr_t)offset,
+                                    type, 0, count, &cache->edges)) {
+        free(cache);
+        return NULL;
+    }
+    debug(OGX_LOG_VBO, "Created edge list for VBO %d (%d edges)",
+          vbo, cache->edges.count / 2);
+    cache->offset = (uintptr_t)offset;
+    cache->mode = mode;
+    cache->type = type;
+    cache->count = count;
+    cache->next = buffer->edges;
+    buffer->edges = cache;
+    return &cache->edges;
+}
@@ -33,17 +33,93 @@ POSSIBILITY OF SUCH DAMAGE.
 #define OPENGX_VBO_H
 
 #include "types.h"
+#include "wireframe.h"
+
+#include <GL/gl.h>
+
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Identifies a conversion of the attribute data stored in a VBO */
+typedef struct {
+    uintptr_t offset;
+    uint16_t stride; /* stride of the source data */
+    uint16_t type; /* GL type of the source data */
+    uint8_t size; /* number of components in the source data */
+    uint8_t attribute; /* GX attribute */
+    float max_error; /* maximum quantization error, 0 for no quantization */
+} OgxVboShadowKey;
+
+/* The GX format of the converted data */
+typedef struct {
+    uint8_t stride; /* size of a converted element, in bytes */
+    uint8_t size; /* GX component size */
+    uint8_t frac; /* number of fractional bits */
+} OgxVboShadowFormat;
+
+/* Converts count elements from src into dst. If dst is NULL, the function
+ * is only asked to examine the source data and choose the output format. */
+typedef void (*OgxVboConvertFunc)(void *dst, const void *src, int count,
+                                  const OgxVboShadowKey *key,
+                                  OgxVboShadowFormat *format);
+
 /* The offset is a void* because that's how it is specified in most OpenGL APIs
  * due to compatibility reasons. */
 void *_ogx_vbo_get_data(VboType vbo, const void *offset);
 /* Mark the given VBO as in use by the GPU */
 void _ogx_vbo_set_in_use(VboType vbo);
 void _ogx_vbo_clear_unbound_buffers(void);
+/* Returns a copy of the VBO attribute data described by key, converted by the
+ * given function. The format should be initialized with the format that the
+ * conversion would produce; the converter can alter it, and the actual format
+ * of the returned data is written back. The conversion happens only once: the
+ * result is cached until the VBO contents change. Returns NULL on failure. */
+void *_ogx_vbo_get_shadow_data(VboType vbo, const OgxVboShadowKey *key,
+                               int src_elem_size, OgxVboShadowFormat *format,
+                               OgxVboConvertFunc convert);
+/* Maximum error allowed when quantizing the float data of the VBO into fixed
+ * point formats; 0 if quantization is disabled. */
+float _ogx_vbo_get_max_error(VboType vbo);
+
+/* Identifies a range of vertex positions stored in a VBO */
+typedef struct {
+    uintptr_t offset;
+    uint16_t stride; /* stride of the source data */
+    uint16_t type; /* GL type of the source data */
+    uint8_t size; /* number of components in the source data */
+    int first;
+    int count; /* -1 for all the elements up to the end of the buffer */
+} OgxVboBoundsKey;
+
+typedef struct {
+    float min[3];
+    float max[3];
+} OgxVboBounds;
+
+/* Computes the axis-aligned bounding box of the positions described by key.
+ * The result is cached until the VBO contents change. Returns false if the
+ * range is empty or the data type is not supported. */
+bool _ogx_vbo_get_bounds(VboType vbo, const OgxVboBoundsKey *key,
+                         OgxVboBounds *bounds);
+/* Returns the range of the count index values of the given type stored at
+ * offset; like the bounding boxes, the result is cached. */
+bool _ogx_vbo_get_index_range(VboType vbo, const void *offset, GLenum type,
+                              int count, GLuint *min_index,
+                              GLuint *max_index);
+
+/* Returns the wireframe edges (see _ogx_wireframe_build_edges()) of the
+ * primitive drawn from the count indices of the given type stored at offset.
+ * The list is cached until the VBO contents change. Returns NULL if the
+ * primitive has no edges. */
+const OgxEdgeList *_ogx_vbo_get_edges(VboType vbo, GLenum mode,
+                                      const void *offset, GLenum type,
+                                      int count);
+
+/* GL_OGX_vertex_quantization extension */
+void glBufferQuantizationOGX(GLenum target, GLfloat max_error);
 
 #ifdef __cplusplus
 } // extern C
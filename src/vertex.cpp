@@ -137,6 +137,11 @@ void glVertex3d(GLdouble x, GLdouble y, GLdouble z)
 
 void glVertex3f(GLfloat x, GLfloat y, GLfloat z)
 {
+    if (glparamstate.imm_mode.streaming &&
+        glparamstate.imm_mode.current_numverts == IMM_CHUNK_SIZE) {
+        _ogx_immediate_flush(false);
+    }
+
     if (glparamstate.imm_mode.current_numverts >= glparamstate.imm_mode.current_vertices_size) {
         if (!glparamstate.imm_mode.current_vertices) return;
         int current_size = glparamstate.imm_mode.current_vertices_size;
@@ -0,0 +1,181 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+#include "wireframe.h"
+
+#include "debug.h"
+#include "utils.h"
+
+#include <malloc.h>
+#include <stdint.h>
+
+#define NO_EDGE UINT64_MAX
+
+typedef struct {
+    const void *indices;
+    GLenum type;
+    int first;
+    /* Hash set of the edges added so far */
+    uint64_t *set;
+    uint32_t set_mask;
+    OgxEdgeList *edges;
+} EdgeBuilder;
+
+static inline GLuint vertex_index(const EdgeBuilder *b, int i)
+{
+    return b->indices ? read_index(b->indices, b->type, i) : b->first + i;
+}
+
+static void add_edge(EdgeBuilder *b, int i0, int i1)
+{
+    GLuint v0 = vertex_index(b, i0);
+    GLuint v1 = vertex_index(b, i1);
+    if (v0 == v1) return; /* Degenerate polygons */
+
+    if (v0 > v1) {
+        GLuint tmp = v0; v0 = v1; v1 = tmp;
+    }
+    uint64_t key = ((uint64_t)v0 << 32) | v1;
+    uint32_t slot = (uint32_t)(key * 0x9e3779b97f4a7c15ull >> 32) & b->set_mask;
+    while (b->set[slot] != NO_EDGE) {
+        if (b->set[slot] == key) return;
+        slot = (slot + 1) & b->set_mask;
+    }
+    b->set[slot] = key;
+
+    OgxEdgeList *edges = b->edges;
+    edges->indices[edges->count++] = v0;
+    edges->indices[edges->count++] = v1;
+    if (v0 < edges->min_index) edges->min_index = v0;
+    if (v1 > edges->max_index) edges->max_index = v1;
+}
+
+static void add_polygon_edges(EdgeBuilder *b, const int *vertices, int n)
+{
+    for (int i = 0; i < n; i++) {
+        add_edge(b, vertices[i], vertices[(i + 1) % n]);
+    }
+}
+
+static int max_edges(GLenum mode, int count)
+{
+    switch (mode) {
+    case GL_TRIANGLES:
+    case GL_QUADS:
+    case GL_POLYGON:
+        return count;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+        return count >= 3 ? 2 * count - 3 : 0;
+    case GL_QUAD_STRIP:
+        return count >= 4 ? 3 * (count / 2) - 2 : 0;
+    }
+    return 0;
+}
+
+bool _ogx_wireframe_build_edges(GLenum mode, const void *indices, GLenum type,
+                                int first, int count, OgxEdgeList *edges)
+{
+    int n = max_edges(mode, count);
+    if (n <= 0) return false;
+
+    /* Keep the hash set at most half full */
+    uint32_t set_size = 1;
+    while (set_size < 2 * n) set_size <<= 1;
+    uint64_t *set = malloc(set_size * sizeof(uint64_t));
+    edges->indices = malloc(2 * n * sizeof(GLuint));
+    if (!set || !edges->indices) {
+        warning("Out of memory allocating the wireframe edges");
+        free(set);
+        free(edges->indices);
+        return false;
+    }
+    memset(set, 0xff, set_size * sizeof(uint64_t));
+    edges->count = 0;
+    edges->min_index = UINT32_MAX;
+    edges->max_index = 0;
+
+    EdgeBuilder b = { indices, type, first, set, set_size - 1, edges };
+    int v[4];
+    switch (mode) {
+    case GL_TRIANGLES:
+        for (int i = 0; i + 2 < count; i += 3) {
+            v[0] = i; v[1] = i + 1; v[2] = i + 2;
+            add_polygon_edges(&b, v, 3);
+        }
+        break;
+    case GL_TRIANGLE_STRIP:
+        for (int i = 0; i + 2 < count; i++) {
+            v[0] = i; v[1] = i + 1; v[2] = i + 2;
+            add_polygon_edges(&b, v, 3);
+        }
+        break;
+    case GL_TRIANGLE_FAN:
+        for (int i = 1; i + 1 < count; i++) {
+            v[0] = 0; v[1] = i; v[2] = i + 1;
+            add_polygon_edges(&b, v, 3);
+        }
+        break;
+    case GL_QUADS:
+        for (int i = 0; i + 3 < count; i += 4) {
+            v[0] = i; v[1] = i + 1; v[2] = i + 2; v[3] = i + 3;
+            add_polygon_edges(&b, v, 4);
+        }
+        break;
+    case GL_QUAD_STRIP:
+        for (int i = 0; i + 3 < count; i += 2) {
+            v[0] = i; v[1] = i + 1; v[2] = i + 3; v[3] = i + 2;
+            add_polygon_edges(&b, v, 4);
+        }
+        break;
+    case GL_POLYGON:
+        for (int i = 0; i < count; i++) {
+            add_edge(&b, i, (i + 1) % count);
+        }
+        break;
+    }
+    free(set);
+
+    if (edges->count == 0) {
+        free(edges->indices);
+        return false;
+    }
+    /* Release the unused memory */
+    GLuint *shrunk = realloc(edges->indices, edges->count * sizeof(GLuint));
+    if (shrunk) edges->indices = shrunk;
+    return true;
+}
+
+void _ogx_wireframe_free_edges(OgxEdgeList *edges)
+{
+    free(edges->indices);
+    edges->indices = NULL;
+    edges->count = 0;
+}
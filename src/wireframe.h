@@ -0,0 +1,72 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+
+#ifndef OPENGX_WIREFRAME_H
+#define OPENGX_WIREFRAME_H
+
+#include <GL/gl.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The unique edges of the polygons drawn by a primitive, as pairs of vertex
+ * indices to be drawn as GL_LINES */
+typedef struct {
+    GLuint *indices;
+    int count; /* number of indices, twice the number of edges */
+    GLuint min_index;
+    GLuint max_index;
+} OgxEdgeList;
+
+/* Whether the GL primitive is made of polygons, and is therefore affected by
+ * glPolygonMode() */
+static inline bool _ogx_wireframe_is_polygon(GLenum mode)
+{
+    return mode >= GL_TRIANGLES && mode <= GL_POLYGON;
+}
+
+/* Builds the edge list of the polygons formed by count vertices of the given
+ * GL primitive. The vertex indices are read from the indices array (of the
+ * given type) if this is not NULL, otherwise they are the consecutive numbers
+ * starting from first. Triangle diagonals of quads and polygons are not part
+ * of the list. Returns false if the list is empty or if memory could not be
+ * allocated; otherwise, the list must be released with
+ * _ogx_wireframe_free_edges(). */
+bool _ogx_wireframe_build_edges(GLenum mode, const void *indices, GLenum type,
+                                int first, int count, OgxEdgeList *edges);
+void _ogx_wireframe_free_edges(OgxEdgeList *edges);
+
+#ifdef __cplusplus
+} // extern C
+#endif
+
+#endif /* OPENGX_WIREFRAME_H */
@@ -0,0 +1,466 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Checks that the optimizations applied to display lists when they are
+ * compiled (folding of matrix operations, dropping of redundant state
+ * changes and merging of draws) don't change what gets drawn: the same
+ * commands are run once as a single list, which gets optimized, and once as a
+ * sequence of lists holding one command each, which can't be.
+ * Also checks that the vertex setup reused across the lists run by
+ * glCallLists() matches the one each list was compiled with, and that lists
+ * with a baked render state (OGX_HINT_BAKE_CALL_LISTS) draw like the others. */
+
+#include "opengx.h"
+#include "state.h"
+#include "test.h"
+
+#include <GL/gl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_VERTICES 64
+/* The vertices of the draws in the lists: the position, and the indices of
+ * the current normal and of the two colors */
+#define LIST_VERTEX_SIZE (12 + 1 + 2)
+#define MAX_INDICES 4096
+
+typedef void (*Step)(void);
+
+/* The vertex positions are (index, 0, 0), so that the index of each vertex can
+ * be read back from the FIFO */
+static float s_positions[NUM_VERTICES][3];
+
+/* The GX registers (BP and XF) as set by all the FIFO data so far; the BP ones
+ * are indexed by the upper 16 bits of their value (see gxhost.h), and store
+ * the lower 16 bits plus one. */
+typedef struct {
+    uint32_t bp[0x10000];
+    uint32_t xf[0x1100];
+} Registers;
+
+static Registers s_registers;
+
+/* What gets drawn: a sequence of batches of primitives, each drawn with a
+ * given register state */
+typedef struct {
+    uint32_t state_hash;
+    uint8_t mode;
+    int num_indices;
+    int indices[MAX_INDICES];
+} Batch;
+
+typedef struct {
+    Batch batches[64];
+    int num_batches;
+} Output;
+
+static Output s_optimized, s_unoptimized;
+
+static uint32_t hash_registers(const Registers *registers)
+{
+    const uint32_t *words = (const uint32_t *)registers;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(Registers) / 4; i++) {
+        hash = (hash ^ words[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void on_bp_load(uint32_t value, void *user_data)
+{
+    s_registers.bp[value >> 16] = (value & 0xffff) + 1;
+}
+
+static void on_xf_load(uint32_t address, int count, const uint8_t *words,
+                       void *user_data)
+{
+    for (int i = 0; i < count && address + i < 0x1100; i++) {
+        const uint8_t *w = words + i * 4;
+        s_registers.xf[address + i] =
+            (w[0] << 24) | (w[1] << 16) | (w[2] << 8) | w[3];
+    }
+}
+
+/* Consecutive primitives of the same kind drawn with the same state are
+ * joined into a single batch, so that merged draws compare equal to the
+ * original ones */
+static void on_primitive(uint8_t mode, const uint8_t *vertices, int count,
+                         void *user_data)
+{
+    Output *out = user_data;
+    uint32_t state_hash = hash_registers(&s_registers);
+    Batch *batch = out->num_batches > 0 ?
+        &out->batches[out->num_batches - 1] : NULL;
+    if (!batch || batch->state_hash != state_hash || batch->mode != mode) {
+        if (out->num_batches == sizeof(out->batches) / sizeof(Batch)) {
+            fprintf(stderr, "Too many batches\n");
+            test_failures++;
+            return;
+        }
+        batch = &out->batches[out->num_batches++];
+        batch->state_hash = state_hash;
+        batch->mode = mode;
+        batch->num_indices = 0;
+    }
+    /* Only independent primitives can be merged */
+    TEST_CHECK(mode == GX_POINTS || mode == GX_LINES ||
+               mode == GX_TRIANGLES || mode == GX_QUADS);
+    for (int i = 0; i < count && batch->num_indices < MAX_INDICES; i++) {
+        batch->indices[batch->num_indices++] =
+            (int)test_read_f32(vertices + i * LIST_VERTEX_SIZE);
+    }
+}
+
+static void reset_state(void)
+{
+    static const GLfloat ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
+    static const GLfloat diffuse[] = { 0.8f, 0.8f, 0.8f, 1.0f };
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glDisable(GL_LIGHTING);
+    glDisable(GL_LIGHT0);
+    glDisable(GL_BLEND);
+    glDisable(GL_COLOR_MATERIAL);
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBlendFunc(GL_ONE, GL_ZERO);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, ambient);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glFlush();
+}
+
+static void update_registers(void)
+{
+    TestFifoHandlers handlers = { NULL, on_bp_load, on_xf_load };
+    TEST_CHECK(test_parse_fifo(LIST_VERTEX_SIZE, &handlers, NULL));
+    gxhost_fifo_clear();
+}
+
+static void run_lists(const GLuint *lists, int count, Output *out)
+{
+    reset_state();
+    update_registers();
+    for (int i = 0; i < count; i++) glCallList(lists[i]);
+    glFlush();
+
+    out->num_batches = 0;
+    TestFifoHandlers handlers = { on_primitive, on_bp_load, on_xf_load };
+    TEST_CHECK(test_parse_fifo(LIST_VERTEX_SIZE, &handlers, out));
+    gxhost_fifo_clear();
+}
+
+static bool outputs_equal(const Output *a, const Output *b)
+{
+    if (a->num_batches != b->num_batches) return false;
+    for (int i = 0; i < a->num_batches; i++) {
+        const Batch *ba = &a->batches[i], *bb = &b->batches[i];
+        if (ba->state_hash != bb->state_hash || ba->mode != bb->mode ||
+            ba->num_indices != bb->num_indices ||
+            memcmp(ba->indices, bb->indices,
+                   ba->num_indices * sizeof(int)) != 0) return false;
+    }
+    return true;
+}
+
+static void print_output(const char *name, const Output *out)
+{
+    fprintf(stderr, "  %s:", name);
+    for (int i = 0; i < out->num_batches; i++) {
+        const Batch *b = &out->batches[i];
+        fprintf(stderr, " [state %08x mode 0x%02x, %d vertices]",
+                b->state_hash, b->mode, b->num_indices);
+    }
+    fprintf(stderr, "\n");
+}
+
+static void check_steps(const char *name, const Step *steps, int count)
+{
+    GLuint single = glGenLists(1);
+    glNewList(single, GL_COMPILE);
+    for (int i = 0; i < count; i++) steps[i]();
+    glEndList();
+
+    GLuint first = glGenLists(count);
+    for (int i = 0; i < count; i++) {
+        glNewList(first + i, GL_COMPILE);
+        steps[i]();
+        glEndList();
+    }
+
+    run_lists(&single, 1, &s_optimized);
+    GLuint lists[64];
+    for (int i = 0; i < count; i++) lists[i] = first + i;
+    run_lists(lists, count, &s_unoptimized);
+
+    if (s_unoptimized.num_batches == 0 ||
+        !outputs_equal(&s_optimized, &s_unoptimized)) {
+        fprintf(stderr, "%s: the optimized list draws differently\n", name);
+        print_output("optimized", &s_optimized);
+        print_output("unoptimized", &s_unoptimized);
+        test_failures++;
+    }
+
+    glDeleteLists(single, 1);
+    glDeleteLists(first, count);
+}
+
+static void draw_triangle(void) { glDrawArrays(GL_TRIANGLES, 0, 3); }
+static void draw_two_triangles(void) { glDrawArrays(GL_TRIANGLES, 3, 6); }
+static void draw_partial_triangles(void) { glDrawArrays(GL_TRIANGLES, 9, 4); }
+static void draw_quads(void) { glDrawArrays(GL_QUADS, 16, 8); }
+static void draw_lines(void) { glDrawArrays(GL_LINES, 24, 5); }
+
+static void push(void) { glPushMatrix(); }
+static void pop(void) { glPopMatrix(); }
+static void translate(void) { glTranslatef(1.0f, -2.0f, 0.5f); }
+static void scale(void) { glScalef(2.0f, 0.5f, 4.0f); }
+static void load_identity(void) { glLoadIdentity(); }
+
+static void test_matrices(void)
+{
+    static const Step steps[] = {
+        push, translate, scale, translate, draw_triangle, pop,
+        draw_triangle, push, scale, push, pop, translate, draw_triangle,
+        load_identity, translate, draw_triangle, pop,
+    };
+    check_steps("matrices", steps, sizeof(steps) / sizeof(steps[0]));
+}
+
+static void enable_blend(void) { glEnable(GL_BLEND); }
+static void disable_blend(void) { glDisable(GL_BLEND); }
+static void blend_add(void) { glBlendFunc(GL_ONE, GL_ONE); }
+static void blend_alpha(void)
+{
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+static void test_redundant_state(void)
+{
+    static const Step steps[] = {
+        enable_blend, blend_add, draw_triangle, enable_blend, blend_add,
+        draw_triangle, blend_alpha, draw_triangle, blend_add, disable_blend,
+        draw_triangle, enable_blend, blend_alpha, blend_add, draw_triangle,
+    };
+    check_steps("redundant state", steps, sizeof(steps) / sizeof(steps[0]));
+}
+
+static const GLfloat s_red[] = { 1.0f, 0.0f, 0.0f, 1.0f };
+static const GLfloat s_blue[] = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+static void enable_lighting(void)
+{
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+}
+static void front_red(void)
+{
+    glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, s_red);
+}
+static void front_diffuse_blue(void)
+{
+    glMaterialfv(GL_FRONT, GL_DIFFUSE, s_blue);
+}
+static void front_ambient_blue(void)
+{
+    glMaterialfv(GL_FRONT, GL_AMBIENT, s_blue);
+}
+static void both_diffuse_red(void)
+{
+    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, s_red);
+}
+static void front_diffuse_red(void)
+{
+    glMaterialfv(GL_FRONT, GL_DIFFUSE, s_red);
+}
+
+static void test_materials(void)
+{
+    /* The same material is set under different names */
+    static const Step steps[] = {
+        enable_lighting, front_red, draw_triangle, front_diffuse_blue,
+        draw_triangle, front_red, draw_triangle, front_ambient_blue,
+        front_red, draw_triangle, front_diffuse_red, front_diffuse_blue,
+        both_diffuse_red, draw_triangle, front_diffuse_blue,
+        front_diffuse_red, draw_triangle,
+    };
+    check_steps("materials", steps, sizeof(steps) / sizeof(steps[0]));
+}
+
+static void test_merged_draws(void)
+{
+    static const Step steps[] = {
+        draw_triangle, draw_two_triangles, draw_triangle,
+        draw_partial_triangles, draw_triangle, draw_quads, draw_quads,
+        draw_lines, draw_lines, enable_blend, draw_triangle, draw_triangle,
+        disable_blend,
+    };
+    check_steps("merged draws", steps, sizeof(steps) / sizeof(steps[0]));
+}
+
+/* The lists draw the same vertices, but with different vertex formats */
+static void test_vertex_formats(bool inline_lists)
+{
+    static const float positions[] = { 0, 0, 1, 0, 1, 1, 0, 1, 1 };
+    const GXHostVertexState *vs = gxhost_vertex_state();
+    OgxHints hints = glparamstate.hints;
+
+    if (inline_lists) glparamstate.hints |= OGX_HINT_INLINE_CALL_LISTS;
+    GLuint lists = glGenLists(3);
+    glVertexPointer(2, GL_FLOAT, 0, positions);
+    glNewList(lists, GL_COMPILE);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEndList();
+    glVertexPointer(3, GL_FLOAT, 0, positions);
+    glNewList(lists + 1, GL_COMPILE);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEndList();
+    glNewList(lists + 2, GL_COMPILE);
+    glCallList(lists + 1);
+    glCallList(lists);
+    glEndList();
+
+    GLuint order[] = { lists + 1, lists };
+    glCallLists(2, GL_UNSIGNED_INT, order);
+    TEST_CHECK_EQ(vs->vtx_attr_fmt[GX_VTXFMT0][GX_VA_POS].comptype, GX_POS_XY);
+
+    glCallList(lists + 2);
+    TEST_CHECK_EQ(vs->vtx_attr_fmt[GX_VTXFMT0][GX_VA_POS].comptype, GX_POS_XY);
+
+    glDeleteLists(lists, 3);
+    glparamstate.hints = hints;
+    glVertexPointer(3, GL_FLOAT, 0, s_positions);
+}
+
+static GLuint s_texture;
+
+static void textured_draw(void)
+{
+    glBindTexture(GL_TEXTURE_2D, s_texture);
+    glEnable(GL_TEXTURE_2D);
+    enable_blend();
+    blend_alpha();
+    draw_triangle();
+    disable_blend();
+    draw_two_triangles();
+    glDisable(GL_TEXTURE_2D);
+}
+
+static void upload_texture(GLubyte value)
+{
+    GLubyte texels[4 * 4 * 4];
+    memset(texels, value, sizeof(texels));
+    glBindTexture(GL_TEXTURE_2D, s_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 4, 4, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, texels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/* Runs the list, and returns how many GX display lists it called */
+static u32 run_counting_gxlists(GLuint list, Output *out)
+{
+    u32 calls = gxhost_call_count(GXHOST_CALL_CallDispList);
+    run_lists(&list, 1, out);
+    return gxhost_call_count(GXHOST_CALL_CallDispList) - calls;
+}
+
+static void check_baked(const char *name)
+{
+    if (!outputs_equal(&s_optimized, &s_unoptimized)) {
+        fprintf(stderr, "%s: the baked list draws differently\n", name);
+        print_output("baked", &s_optimized);
+        print_output("not baked", &s_unoptimized);
+        test_failures++;
+    }
+}
+
+/* The list sets the state of its draws itself; its draws are compiled before
+ * the state is applied */
+static void test_baked_state(void)
+{
+    OgxHints hints = glparamstate.hints;
+    glGenTextures(1, &s_texture);
+    upload_texture(0x80);
+
+    GLuint list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    textured_draw();
+    glEndList();
+
+    glparamstate.hints |= OGX_HINT_BAKE_CALL_LISTS;
+    GLuint baked = glGenLists(1);
+    glNewList(baked, GL_COMPILE);
+    textured_draw();
+    glEndList();
+    glparamstate.hints = hints;
+
+    /* Each draw calls the list of its state, then the one of its vertices */
+    TEST_CHECK_EQ(run_counting_gxlists(list, &s_unoptimized), 2);
+    TEST_CHECK_EQ(run_counting_gxlists(baked, &s_optimized), 4);
+    check_baked("baked state");
+
+    /* The baked texture is still in use by the GPU, so its texels are moved
+     * to new storage: the stale baked state must not be used */
+    upload_texture(0x80); /* retires the previous uses of the texture */
+    gxhost_set_deferred_sync(true);
+    TEST_CHECK_EQ(run_counting_gxlists(baked, &s_optimized), 4);
+    u32 syncs = gxhost_pending_syncs();
+    upload_texture(0x40);
+    /* The texture must have been marked as used by the draw */
+    TEST_CHECK(gxhost_pending_syncs() > syncs);
+    gxhost_retire_all();
+    gxhost_set_deferred_sync(false);
+    TEST_CHECK_EQ(run_counting_gxlists(list, &s_unoptimized), 2);
+    TEST_CHECK_EQ(run_counting_gxlists(baked, &s_optimized), 2);
+    check_baked("re-uploaded texture");
+
+    glDeleteLists(list, 1);
+    glDeleteLists(baked, 1);
+    glDeleteTextures(1, &s_texture);
+}
+
+int main(int argc, char **argv)
+{
+    ogx_initialize();
+    gxhost_set_inline_display_lists(true);
+
+    for (int i = 0; i < NUM_VERTICES; i++) s_positions[i][0] = i;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, s_positions);
+
+    test_matrices();
+    test_redundant_state();
+    test_materials();
+    test_merged_draws();
+    test_vertex_formats(false);
+    test_vertex_formats(true);
+    test_baked_state();
+
+    return test_result();
+}
@@ -0,0 +1,206 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Checks the GX primitives emitted for draws exceeding the 65535 vertex limit
+ * of GX_Begin(): they must be split into several primitives which, taken
+ * together, draw the same triangles, lines and points as the GL primitive. */
+
+#include "opengx.h"
+#include "test.h"
+
+#include <GL/gl.h>
+#include <string.h>
+
+#define MAX_VERTICES 140001
+
+/* The vertex positions are (index, 0, 0), so that the index of each vertex can
+ * be read back from the FIFO */
+static float s_positions[MAX_VERTICES][3];
+static GLuint s_indices[MAX_VERTICES];
+
+/* The primitives drawn, expanded into a list of vertex indices: 1 per point,
+ * 2 per line and 3 per triangle */
+static int s_expected[MAX_VERTICES * 6];
+static int s_drawn[MAX_VERTICES * 6];
+static int s_primitive[0x10000];
+static int s_vertices[MAX_VERTICES + 1];
+
+/* Expands the vertices of a GX primitive into points, lines or triangles,
+ * written to out; returns the number of indices written */
+static int expand(uint8_t gx_mode, const int *v, int n, int *out)
+{
+    int k = 0;
+    switch (gx_mode) {
+    case GX_POINTS:
+        for (int i = 0; i < n; i++) out[k++] = v[i];
+        break;
+    case GX_LINES:
+        for (int i = 0; i + 1 < n; i += 2) {
+            out[k++] = v[i]; out[k++] = v[i + 1];
+        }
+        break;
+    case GX_LINESTRIP:
+        for (int i = 0; i + 1 < n; i++) {
+            out[k++] = v[i]; out[k++] = v[i + 1];
+        }
+        break;
+    case GX_TRIANGLES:
+        for (int i = 0; i + 2 < n; i += 3) {
+            out[k++] = v[i]; out[k++] = v[i + 1]; out[k++] = v[i + 2];
+        }
+        break;
+    case GX_TRIANGLESTRIP:
+        /* Every other triangle has its first two vertices swapped, to keep
+         * the winding consistent */
+        for (int i = 0; i + 2 < n; i++) {
+            out[k++] = v[i + (i & 1)];
+            out[k++] = v[i + 1 - (i & 1)];
+            out[k++] = v[i + 2];
+        }
+        break;
+    case GX_TRIANGLEFAN:
+        for (int i = 1; i + 1 < n; i++) {
+            out[k++] = v[0]; out[k++] = v[i]; out[k++] = v[i + 1];
+        }
+        break;
+    case GX_QUADS:
+        for (int i = 0; i + 3 < n; i += 4) {
+            out[k++] = v[i]; out[k++] = v[i + 1]; out[k++] = v[i + 2];
+            out[k++] = v[i]; out[k++] = v[i + 2]; out[k++] = v[i + 3];
+        }
+        break;
+    }
+    return k;
+}
+
+typedef struct {
+    uint8_t expected_mode;
+    int num_begins;
+    int num_drawn;
+} ParseData;
+
+/* Expands the primitives found in the FIFO into s_drawn */
+static void parse_primitive(uint8_t mode, const uint8_t *vertices, int count,
+                            void *user_data)
+{
+    ParseData *data = user_data;
+    TEST_CHECK_EQ(mode, data->expected_mode);
+    TEST_CHECK(count > 0);
+    /* The vertices only have a position, of three floats */
+    for (int v = 0; v < count; v++) {
+        s_primitive[v] = (int)test_read_f32(vertices + v * 12);
+    }
+    data->num_drawn += expand(mode, s_primitive, count,
+                              s_drawn + data->num_drawn);
+    data->num_begins++;
+}
+
+static void test_draw(GLenum mode, int count, bool elements)
+{
+    /* The GX primitive drawing the same shapes as the GL one, when given all
+     * the vertices at once */
+    uint8_t gx_mode;
+    int *v = s_vertices;
+    int expected_count = count;
+    for (int i = 0; i < count; i++) v[i] = elements ? s_indices[i] : i;
+    switch (mode) {
+    case GL_POINTS: gx_mode = GX_POINTS; break;
+    case GL_LINES: gx_mode = GX_LINES; break;
+    case GL_LINE_STRIP: gx_mode = GX_LINESTRIP; break;
+    case GL_LINE_LOOP:
+        gx_mode = GX_LINESTRIP;
+        v[expected_count++] = v[0];
+        break;
+    case GL_TRIANGLES: gx_mode = GX_TRIANGLES; break;
+    case GL_TRIANGLE_STRIP:
+    case GL_QUAD_STRIP:
+        gx_mode = GX_TRIANGLESTRIP;
+        break;
+    case GL_TRIANGLE_FAN:
+    case GL_POLYGON:
+        gx_mode = GX_TRIANGLEFAN;
+        break;
+    case GL_QUADS: gx_mode = GX_QUADS; break;
+    default: return;
+    }
+    int num_expected = expand(gx_mode, v, expected_count, s_expected);
+
+    gxhost_fifo_clear();
+    if (elements) {
+        glDrawElements(mode, count, GL_UNSIGNED_INT, s_indices);
+    } else {
+        glDrawArrays(mode, 0, count);
+    }
+    glFlush();
+
+    ParseData data = { gx_mode, 0, 0 };
+    TestFifoHandlers handlers = { parse_primitive };
+    TEST_CHECK(test_parse_fifo(12, &handlers, &data));
+    int num_begins = data.num_begins;
+    int num_drawn = data.num_drawn;
+    int min_begins = (expected_count + 0xfffe) / 0xffff;
+    if (num_drawn != num_expected || num_begins < min_begins ||
+        (expected_count <= 0xffff && num_begins != 1) ||
+        memcmp(s_drawn, s_expected, num_expected * sizeof(int)) != 0) {
+        fprintf(stderr, "Draw mismatch: mode 0x%x, count %d, elements %d "
+                "(%d GX primitives, %d/%d indices)\n", mode, count, elements,
+                num_begins, num_drawn, num_expected);
+        test_failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ogx_initialize();
+
+    for (int i = 0; i < MAX_VERTICES; i++) {
+        s_positions[i][0] = i;
+        /* A permutation of the vertices */
+        s_indices[i] = (i * 7919) % MAX_VERTICES;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, s_positions);
+
+    static const GLenum modes[] = {
+        GL_POINTS, GL_LINES, GL_LINE_STRIP, GL_LINE_LOOP, GL_TRIANGLES,
+        GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN, GL_QUADS, GL_QUAD_STRIP,
+        GL_POLYGON,
+    };
+    static const int counts[] = {
+        100, 65535, 65536, 131070, 140000, MAX_VERTICES,
+    };
+    for (int m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            test_draw(modes[m], counts[c], false);
+            test_draw(modes[m], counts[c], true);
+        }
+    }
+
+    return test_result();
+}
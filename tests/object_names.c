@@ -0,0 +1,127 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Checks the allocation of the names of display lists, textures and buffers:
+ * generated names must never collide with the ones the client is using,
+ * whether they were generated or chosen by the client. */
+
+#define GL_GLEXT_PROTOTYPES
+#include "opengx.h"
+#include "test.h"
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <string.h>
+
+static void test_lists(void)
+{
+    TEST_CHECK_EQ(glGenLists(2), 1);
+
+    /* A list created with a name of the client's choice */
+    glNewList(4, GL_COMPILE);
+    glColor3f(1.0f, 0.0f, 0.0f);
+    glEndList();
+    TEST_CHECK_EQ(glGenLists(1), 3);
+    TEST_CHECK_EQ(glGenLists(2), 5);
+
+    /* Freed names are reused, lowest first */
+    glDeleteLists(2, 2);
+    TEST_CHECK_EQ(glGenLists(1), 2);
+    TEST_CHECK(glIsList(4));
+
+    TEST_CHECK_EQ(glGenLists(-1), 0);
+    TEST_CHECK_EQ(glGetError(), GL_INVALID_VALUE);
+
+    glDeleteLists(1, 6);
+}
+
+static void test_textures(void)
+{
+    GLuint textures[2];
+    glGenTextures(2, textures);
+    TEST_CHECK_EQ(textures[0], 1);
+    TEST_CHECK_EQ(textures[1], 2);
+
+    glBindTexture(GL_TEXTURE_2D, 3);
+    glGenTextures(1, textures);
+    TEST_CHECK_EQ(textures[0], 4);
+
+    GLuint name = 1;
+    glDeleteTextures(1, &name);
+    glGenTextures(1, textures);
+    TEST_CHECK_EQ(textures[0], 1);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GLuint all[] = { 1, 2, 3, 4 };
+    glDeleteTextures(4, all);
+}
+
+static void test_buffers(void)
+{
+    GLuint buffers[3];
+    glGenBuffers(3, buffers);
+    TEST_CHECK_EQ(buffers[0], 1);
+    TEST_CHECK_EQ(buffers[2], 3);
+
+    glDeleteBuffers(1, &buffers[1]);
+    TEST_CHECK(!glIsBuffer(2));
+    glGenBuffers(1, &buffers[1]);
+    TEST_CHECK_EQ(buffers[1], 2);
+
+    /* A buffer whose name was never generated, created by glBufferData() */
+    static const char data[] = "opengx";
+    glBindBuffer(GL_ARRAY_BUFFER, 5);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+    GLuint generated[2];
+    glGenBuffers(2, generated);
+    TEST_CHECK_EQ(generated[0], 4);
+    TEST_CHECK_EQ(generated[1], 6);
+
+    char stored[sizeof(data)] = { 0 };
+    glBindBuffer(GL_ARRAY_BUFFER, 5);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(data), stored);
+    TEST_CHECK(memcmp(stored, data, sizeof(data)) == 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLuint all[] = { 1, 2, 3, 4, 5, 6 };
+    glDeleteBuffers(6, all);
+    glGenBuffers(1, buffers);
+    TEST_CHECK_EQ(buffers[0], 1);
+}
+
+int main(int argc, char **argv)
+{
+    ogx_initialize();
+
+    test_lists();
+    test_textures();
+    test_buffers();
+
+    return test_result();
+}
@@ -0,0 +1,134 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#ifndef OPENGX_TEST_H
+#define OPENGX_TEST_H
+
+/* Small helpers shared by the test programs: each test is a program which
+ * prints the failed checks and exits with a non-zero status if any. */
+
+#include "gxhost.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", \
+                    __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define TEST_CHECK_EQ(actual, expected) \
+    do { \
+        long long a_ = (actual), e_ = (expected); \
+        if (a_ != e_) { \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", \
+                    __FILE__, __LINE__, #actual, a_, e_); \
+            test_failures++; \
+        } \
+    } while (0)
+
+static inline float test_read_f32(const uint8_t *data)
+{
+    union { uint32_t u; float f; } v;
+    v.u = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    return v.f;
+}
+
+/* Callbacks for the contents of the FIFO; any of them can be NULL */
+typedef struct {
+    /* A primitive: mode is the GX primitive, and vertices points to the data
+     * of its count vertices */
+    void (*primitive)(uint8_t mode, const uint8_t *vertices, int count,
+                      void *user_data);
+    /* A BP register load (see gxhost.h for the meaning of the value) */
+    void (*bp_load)(uint32_t value, void *user_data);
+    /* An XF register load of count words, starting at address */
+    void (*xf_load)(uint32_t address, int count, const uint8_t *words,
+                    void *user_data);
+} TestFifoHandlers;
+
+/* Walks through the data recorded in the FIFO, calling the handlers for each
+ * primitive and register load; the vertices must be vertex_size bytes long.
+ * Returns false if some data could not be parsed. */
+static inline bool test_parse_fifo(int vertex_size,
+                                   const TestFifoHandlers *handlers,
+                                   void *user_data)
+{
+    const uint8_t *data = gxhost_fifo_data();
+    uint32_t size = gxhost_fifo_size();
+    for (uint32_t i = 0; i < size; ) {
+        uint8_t opcode = data[i];
+        if (opcode & 0x80) {
+            int count = (data[i + 1] << 8) | data[i + 2];
+            if (handlers->primitive)
+                handlers->primitive(opcode & 0xf8, data + i + 3, count,
+                                    user_data);
+            i += 3 + count * vertex_size;
+        } else if (opcode == 0x10) { /* XF registers */
+            uint32_t header = (data[i + 1] << 24) | (data[i + 2] << 16) |
+                (data[i + 3] << 8) | data[i + 4];
+            int count = (header >> 16) + 1;
+            if (handlers->xf_load)
+                handlers->xf_load(header & 0xffff, count, data + i + 5,
+                                  user_data);
+            i += 5 + 4 * count;
+        } else if (opcode == 0x08) { /* CP register */
+            i += 6;
+        } else if (opcode == 0x61) { /* BP register */
+            uint32_t value = (data[i + 1] << 24) | (data[i + 2] << 16) |
+                (data[i + 3] << 8) | data[i + 4];
+            if (handlers->bp_load) handlers->bp_load(value, user_data);
+            i += 5;
+        } else if (opcode == 0x00) { /* NOP */
+            i++;
+        } else {
+            fprintf(stderr, "Unknown opcode 0x%02x at %u\n", opcode, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline int test_result(void)
+{
+    if (test_failures > 0) {
+        fprintf(stderr, "%d checks failed\n", test_failures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif /* OPENGX_TEST_H */
@@ -0,0 +1,301 @@
+/*****************************************************************************
+Copyright (c) 2026  Alberto Mardegan (mardy@users.sourceforge.net)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. Neither the name of copyright holders nor the names of its
+   contributors may be used to endorse or promote products derived
+   from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL COPYRIGHT HOLDERS OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+/* Checks the edge lists built for drawing polygons with glPolygonMode(GL_LINE):
+ * each edge must appear once, and the diagonals splitting quads and polygons
+ * into triangles must not appear at all. The draws run from display lists
+ * must use them too. */
+
+#include "opengx.h"
+#include "test.h"
+#include "wireframe.h"
+
+#include <GL/gl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BIG_STRIP_VERTICES 70000
+/* The vertices of the draws in the display lists: the position, and the
+ * indices of the current normal and of the two colors */
+#define LIST_VERTEX_SIZE (12 + 1 + 2)
+
+static float s_positions[BIG_STRIP_VERTICES][3];
+
+static int compare_edges(const void *a, const void *b)
+{
+    const GLuint *ea = a, *eb = b;
+    if (ea[0] != eb[0]) return ea[0] < eb[0] ? -1 : 1;
+    if (ea[1] != eb[1]) return ea[1] < eb[1] ? -1 : 1;
+    return 0;
+}
+
+/* Sorts the edges, putting the lowest index of each first */
+static void sort_edges(OgxEdgeList *edges)
+{
+    for (int i = 0; i < edges->count; i += 2) {
+        if (edges->indices[i] > edges->indices[i + 1]) {
+            GLuint tmp = edges->indices[i];
+            edges->indices[i] = edges->indices[i + 1];
+            edges->indices[i + 1] = tmp;
+        }
+    }
+    qsort(edges->indices, edges->count / 2, 2 * sizeof(GLuint), compare_edges);
+}
+
+/* Compares the edges (in any order) with the expected ones, given as sorted
+ * pairs of vertex indices with the lowest index first */
+static void check_edges(const char *name, OgxEdgeList *edges,
+                        const GLuint *expected, int count)
+{
+    sort_edges(edges);
+    if (edges->count != count ||
+        memcmp(edges->indices, expected, count * sizeof(GLuint)) != 0) {
+        fprintf(stderr, "%s: wrong edges:", name);
+        for (int i = 0; i < edges->count; i += 2) {
+            fprintf(stderr, " %u-%u", edges->indices[i], edges->indices[i + 1]);
+        }
+        fprintf(stderr, "\n");
+        test_failures++;
+    }
+}
+
+static void test_strip(void)
+{
+    OgxEdgeList edges;
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_TRIANGLE_STRIP, NULL, 0, 0, 6,
+                                          &edges));
+    static const GLuint expected[] = {
+        0, 1, 0, 2, 1, 2, 1, 3, 2, 3, 2, 4, 3, 4, 3, 5, 4, 5,
+    };
+    check_edges("strip", &edges, expected, 18);
+    TEST_CHECK_EQ(edges.min_index, 0);
+    TEST_CHECK_EQ(edges.max_index, 5);
+    _ogx_wireframe_free_edges(&edges);
+}
+
+static void test_fan(void)
+{
+    /* The fan is given by indices, around vertex 7 */
+    static const GLushort indices[] = { 7, 2, 3, 4, 5 };
+    OgxEdgeList edges;
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_TRIANGLE_FAN, indices,
+                                          GL_UNSIGNED_SHORT, 0, 5, &edges));
+    static const GLuint expected[] = {
+        2, 3, 2, 7, 3, 4, 3, 7, 4, 5, 4, 7, 5, 7,
+    };
+    check_edges("fan", &edges, expected, 14);
+    TEST_CHECK_EQ(edges.min_index, 2);
+    TEST_CHECK_EQ(edges.max_index, 7);
+    _ogx_wireframe_free_edges(&edges);
+}
+
+static void test_quad_strip(void)
+{
+    /* Two quads, 10-11-13-12 and 12-13-15-14, sharing the edge 12-13 */
+    OgxEdgeList edges;
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_QUAD_STRIP, NULL, 0, 10, 6,
+                                          &edges));
+    static const GLuint expected[] = {
+        10, 11, 10, 12, 11, 13, 12, 13, 12, 14, 13, 15, 14, 15,
+    };
+    check_edges("quad strip", &edges, expected, 14);
+    _ogx_wireframe_free_edges(&edges);
+}
+
+static void test_quads_and_polygon(void)
+{
+    OgxEdgeList edges;
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_QUADS, NULL, 0, 0, 4, &edges));
+    static const GLuint quad[] = { 0, 1, 0, 3, 1, 2, 2, 3 };
+    check_edges("quad", &edges, quad, 8);
+    _ogx_wireframe_free_edges(&edges);
+
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_POLYGON, NULL, 0, 0, 5, &edges));
+    static const GLuint polygon[] = { 0, 1, 0, 4, 1, 2, 2, 3, 3, 4 };
+    check_edges("polygon", &edges, polygon, 10);
+    _ogx_wireframe_free_edges(&edges);
+
+    /* Two triangles sharing an edge, and a degenerate one */
+    static const GLuint indices[] = { 0, 1, 2, 2, 1, 3, 4, 4, 5 };
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_TRIANGLES, indices,
+                                          GL_UNSIGNED_INT, 0, 9, &edges));
+    static const GLuint triangles[] = {
+        0, 1, 0, 2, 1, 2, 1, 3, 2, 3, 4, 5,
+    };
+    check_edges("triangles", &edges, triangles, 12);
+    _ogx_wireframe_free_edges(&edges);
+}
+
+typedef struct {
+    int num_begins;
+    int num_vertices;
+} LineCount;
+
+static void count_lines(uint8_t mode, const uint8_t *vertices, int count,
+                        void *user_data)
+{
+    LineCount *lines = user_data;
+    TEST_CHECK_EQ(mode, GX_LINES);
+    TEST_CHECK_EQ(count % 2, 0);
+    lines->num_begins++;
+    lines->num_vertices += count;
+}
+
+/* A strip whose edges don't fit in a single GX primitive */
+static void test_big_strip(void)
+{
+    int n = BIG_STRIP_VERTICES;
+    OgxEdgeList edges;
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_TRIANGLE_STRIP, NULL, 0, 0, n,
+                                          &edges));
+    int num_edges = 2 * n - 3;
+    TEST_CHECK_EQ(edges.count, 2 * num_edges);
+    TEST_CHECK_EQ(edges.min_index, 0);
+    TEST_CHECK_EQ(edges.max_index, n - 1);
+    _ogx_wireframe_free_edges(&edges);
+
+    for (int i = 0; i < n; i++) s_positions[i][0] = i;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, s_positions);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    gxhost_fifo_clear();
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, n);
+    glFlush();
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    LineCount lines = { 0, 0 };
+    TestFifoHandlers handlers = { count_lines };
+    TEST_CHECK(test_parse_fifo(12, &handlers, &lines));
+    TEST_CHECK(lines.num_begins > 1);
+    TEST_CHECK_EQ(lines.num_vertices, 2 * num_edges);
+}
+
+/* The primitives drawn by a display list; the vertex positions hold their
+ * indices */
+typedef struct {
+    uint8_t mode;
+    int num_begins;
+    OgxEdgeList edges;
+    int capacity;
+} ListDraw;
+
+static void record_vertices(uint8_t mode, const uint8_t *vertices, int count,
+                            void *user_data)
+{
+    ListDraw *draw = user_data;
+    draw->mode = mode;
+    draw->num_begins++;
+    if (draw->edges.count + count > draw->capacity) {
+        draw->capacity = draw->edges.count + count;
+        draw->edges.indices = realloc(draw->edges.indices,
+                                      draw->capacity * sizeof(GLuint));
+    }
+    for (int i = 0; i < count; i++) {
+        draw->edges.indices[draw->edges.count++] =
+            (GLuint)test_read_f32(vertices + i * LIST_VERTEX_SIZE);
+    }
+}
+
+static void run_list(GLuint list, GLenum polygon_mode, ListDraw *draw)
+{
+    glPolygonMode(GL_FRONT_AND_BACK, polygon_mode);
+    gxhost_fifo_clear();
+    glCallList(list);
+    glFlush();
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    draw->num_begins = 0;
+    draw->edges.count = 0;
+    TestFifoHandlers handlers = { record_vertices };
+    TEST_CHECK(test_parse_fifo(LIST_VERTEX_SIZE, &handlers, draw));
+}
+
+static void test_call_list(void)
+{
+    ListDraw draw = { 0 };
+    gxhost_set_inline_display_lists(true);
+
+    /* The polygon mode at compile time must not matter */
+    GLuint list = glGenLists(1);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glNewList(list, GL_COMPILE);
+    glDrawArrays(GL_QUADS, 0, 8);
+    glEndList();
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    run_list(list, GL_LINE, &draw);
+    TEST_CHECK_EQ(draw.mode, GX_LINES);
+    static const GLuint quads[] = {
+        0, 1, 0, 3, 1, 2, 2, 3, 4, 5, 4, 7, 5, 6, 6, 7,
+    };
+    check_edges("list quads", &draw.edges, quads, 16);
+
+    run_list(list, GL_FILL, &draw);
+    TEST_CHECK_EQ(draw.mode, GX_QUADS);
+    TEST_CHECK_EQ(draw.edges.count, 8);
+
+    run_list(list, GL_POINT, &draw);
+    TEST_CHECK_EQ(draw.mode, GX_POINTS);
+    TEST_CHECK_EQ(draw.edges.count, 8);
+    glDeleteLists(list, 1);
+
+    /* A strip whose edges don't fit in a single GX primitive */
+    int n = 40000;
+    list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, n);
+    glEndList();
+    run_list(list, GL_LINE, &draw);
+    TEST_CHECK_EQ(draw.mode, GX_LINES);
+    TEST_CHECK(draw.num_begins > 1);
+    OgxEdgeList edges;
+    TEST_CHECK(_ogx_wireframe_build_edges(GL_TRIANGLE_STRIP, NULL, 0, 0, n,
+                                          &edges));
+    sort_edges(&edges);
+    check_edges("list strip", &draw.edges, edges.indices, edges.count);
+    _ogx_wireframe_free_edges(&edges);
+    glDeleteLists(list, 1);
+
+    free(draw.edges.indices);
+    gxhost_set_inline_display_lists(false);
+}
+
+int main(int argc, char **argv)
+{
+    ogx_initialize();
+
+    test_strip();
+    test_fan();
+    test_quad_strip();
+    test_quads_and_polygon();
+    test_big_strip();
+    test_call_list();
+
+    return test_result();
+}